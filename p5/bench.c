@@ -0,0 +1,181 @@
+/**
+ * @file bench.c
+ * @author Jake Donovan (jmpatte8)
+ * Benchmark for the compression function.  It hashes a buffer of random-looking blocks several times
+ * over and reports the best time as cycles per byte and megabytes per second.  Build it with
+ * "make bench" for the unrolled hashBlocks(), or "make bench-table" for the table-driven one.  Then it
+ * hashes a lot of short records, one at a time and with each multi-buffer engine.  Last, it compares
+ * filling a ByteBuffer a byte at a time with the bulk append functions.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "ripeMD.h"
+#include "ripeMulti.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+/** Number of bytes hashed in each run */
+#define BENCH_BYTES ( 16 * 1024 * 1024 )
+
+/** Number of short records hashed by each multi-buffer engine */
+#define RECORDS ( 256 * 1024 )
+
+/** Size of each record, the size of a compressed public key */
+#define RECORD_BYTES 33
+
+/** Number of short buffers padded with padBuffer() */
+#define PAD_BUFFERS ( 1024 * 1024 )
+
+/** Number of runs, keeping the fastest one */
+#define BENCH_RUNS 5
+
+/**
+ * This function reads the processor's cycle counter, or a nanosecond clock on machines without one
+ * @return the current count
+*/
+static unsigned long long cycles()
+{
+#if defined( __x86_64__ ) || defined( __i386__ )
+  return __builtin_ia32_rdtsc();
+#else
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+#endif
+}
+
+/**
+ * This function reads a clock in seconds
+ * @return the current time
+*/
+static double seconds()
+{
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * This function runs the benchmark
+ * @return program exit status
+*/
+int main()
+{
+  byte *data = ( byte * )malloc( BENCH_BYTES );
+  unsigned int seed = 12345;
+  for( int i = 0; i < BENCH_BYTES; i++ ){
+    seed = seed * 1103515245 + 12345;
+    data[ i ] = seed >> 24;
+  }
+
+  HashState state;
+  initState( &state );
+
+  double bestCycles = 0, bestSeconds = 0;
+  for( int run = 0; run < BENCH_RUNS; run++ ){
+    double start = seconds();
+    unsigned long long c0 = cycles();
+    hashBlocks( &state, data, BENCH_BYTES / BLOCK_BYTES );
+    unsigned long long c1 = cycles();
+    double time = seconds() - start;
+
+    if( run == 0 || c1 - c0 < bestCycles ){
+      bestCycles = c1 - c0;
+      bestSeconds = time;
+    }
+  }
+
+  // print the state too, so the work can't be skipped
+  printf( "%.2f cycles/byte, %.1f MB/s (%08x)\n", bestCycles / BENCH_BYTES,
+          BENCH_BYTES / bestSeconds / 1e6, state.A );
+
+  // short records, one at a time
+  double best = 0;
+  for( int run = 0; run < BENCH_RUNS; run++ ){
+    double start = seconds();
+    for( int i = 0; i < RECORDS; i++ ){
+      RipeCtx ctx;
+      ripeInit( &ctx );
+      ripeUpdate( &ctx, data + i * RECORD_BYTES, RECORD_BYTES );
+      ripeFinal( &ctx, &state );
+    }
+    double time = seconds() - start;
+    if( run == 0 || time < best ){
+      best = time;
+    }
+  }
+  printf( "%-8s %.2f M records/s\n", "single", RECORDS / best / 1e6 );
+
+  // then with every engine this processor supports
+  RipeJob *jobs = ( RipeJob * )malloc( RECORDS * sizeof( RipeJob ) );
+  for( int i = 0; i < RECORDS; i++ ){
+    jobs[ i ].data = data + i * RECORD_BYTES;
+    jobs[ i ].len = RECORD_BYTES;
+  }
+
+  char const *names[] = { "scalar", "sse2", "avx2" };
+  for( int e = 0; e < sizeof( names ) / sizeof( names[ 0 ] ); e++ ){
+    if( !ripeSetEngine( names[ e ] ) ){
+      continue;
+    }
+
+    for( int run = 0; run < BENCH_RUNS; run++ ){
+      double start = seconds();
+      ripeMany( jobs, RECORDS );
+      double time = seconds() - start;
+      if( run == 0 || time < best ){
+        best = time;
+      }
+    }
+    printf( "%-8s %.2f M records/s\n", names[ e ], RECORDS / best / 1e6 );
+  }
+
+  // copying into a buffer a byte at a time, and all at once
+  double byteTime = 0, bulkTime = 0;
+  for( int run = 0; run < BENCH_RUNS; run++ ){
+    ByteBuffer *buffer = createBuffer();
+    double start = seconds();
+    for( int i = 0; i < BENCH_BYTES; i++ ){
+      addByte( buffer, data[ i ] );
+    }
+    double time = seconds() - start;
+    if( run == 0 || time < byteTime ){
+      byteTime = time;
+    }
+    freeBuffer( buffer );
+
+    buffer = createBuffer();
+    start = seconds();
+    appendBytes( buffer, data, BENCH_BYTES );
+    time = seconds() - start;
+    if( run == 0 || time < bulkTime ){
+      bulkTime = time;
+    }
+    freeBuffer( buffer );
+  }
+  printf( "addByte     %.1f MB/s\nappendBytes %.1f MB/s\n", BENCH_BYTES / byteTime / 1e6,
+          BENCH_BYTES / bulkTime / 1e6 );
+
+  // padding short buffers, which is mostly zeros
+  ByteBuffer *buffer = createBuffer();
+  best = 0;
+  for( int run = 0; run < BENCH_RUNS; run++ ){
+    double start = seconds();
+    for( int i = 0; i < PAD_BUFFERS; i++ ){
+      buffer->len = i % BLOCK_BYTES;
+      padBuffer( buffer );
+    }
+    double time = seconds() - start;
+    if( run == 0 || time < best ){
+      best = time;
+    }
+  }
+  printf( "padBuffer   %.1f ns each\n", best / PAD_BUFFERS * 1e9 );
+  freeBuffer( buffer );
+
+  free( jobs );
+  free( data );
+  return EXIT_SUCCESS;
+}
@@ -5,9 +5,16 @@
  * of binary files and text files in memory
 */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include "byteBuffer.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 /**
  * This function dynamically allocates a ByteBuffer struct and intializes
@@ -23,6 +30,27 @@ ByteBuffer *createBuffer()
     return buffer;
 }
 
+/**
+ * This function makes sure the given buffer has room for n more bytes, growing it once if it doesn't.
+ * The capacity at least doubles, so adding bytes a few at a time still takes constant time per byte
+ * @param buffer the passed pointer to a ByteBuffer struct
+ * @param n the number of bytes we're about to add
+*/
+void reserve( ByteBuffer *buffer, size_t n )
+{
+    if( buffer->cap - buffer->len >= n ){
+        return;
+    }
+
+    size_t cap = buffer->cap * RESIZE;
+    if( cap < buffer->len + n ){
+        cap = buffer->len + n;
+    }
+
+    buffer->data = ( byte * )realloc( buffer->data, cap * sizeof( byte ) );
+    buffer->cap = cap;
+}
+
 /**
  * This function adds a singly byte to the end of the given buffer, enlarging
  * the data array if necessary
@@ -31,14 +59,38 @@ ByteBuffer *createBuffer()
 */
 void addByte( ByteBuffer *buffer, byte b )
 {
-    if( buffer->len >= buffer->cap ){
-        buffer->cap *= RESIZE;
-        buffer->data = ( byte * )realloc( buffer->data, buffer->cap * sizeof( byte ) );
-    }
-
+    reserve( buffer, 1 );
     buffer->data[ buffer->len++ ] = b;
 }
 
+/**
+ * This function adds n bytes copied from src to the end of the given buffer, enlarging
+ * the data array at most once
+ * @param buffer the passed pointer to a ByteBuffer struct
+ * @param src the bytes we want to add
+ * @param n the number of bytes
+*/
+void appendBytes( ByteBuffer *buffer, byte const *src, size_t n )
+{
+    reserve( buffer, n );
+    memcpy( buffer->data + buffer->len, src, n );
+    buffer->len += n;
+}
+
+/**
+ * This function adds n copies of the same byte to the end of the given buffer, enlarging
+ * the data array at most once
+ * @param buffer the passed pointer to a ByteBuffer struct
+ * @param b the byte we want to add
+ * @param n the number of copies
+*/
+void appendFill( ByteBuffer *buffer, byte b, size_t n )
+{
+    reserve( buffer, n );
+    memset( buffer->data + buffer->len, b, n );
+    buffer->len += n;
+}
+
 /**
  * This function is responsible for freeing all memory for the passed
  * ByteBuffer struct
@@ -53,51 +105,66 @@ void freeBuffer( ByteBuffer *buffer )
 /**
  * This function creates a new ByteBuffer. It initializes the contents
  * of the data array with the contents of the given file. The file should be read in binary.
- * If the file cannot be opened, this function will just return NULL. After creating
- * the buffer from the input file, the buffer's capacity can be any (non-zero) value that is at least
- * as large as the file length. The buffer needs to be padded with additional bytes after it is created,
- * so you need to be sure addByte() works after reading a ByteBuffer from a file.
+ * If the file cannot be opened or read, this function will just return NULL, with errno telling why.
+ * For a regular file, the buffer is sized up front to hold the whole file plus PAD_ROOM bytes, and
+ * the file is read straight into it with a few large read() calls, so nothing is staged on the stack
+ * and files bigger than 4 GiB work. Anything else, like a pipe, is read until the end, growing the
+ * buffer as needed. The buffer needs to be padded with additional bytes after it is created,
+ * so you need to be sure addByte() and appendFill() work after reading a ByteBuffer from a file.
  * @param filename the binary file we want to read from
  * @return our ByteBuffer that we filled with the contents from the param binary file
 */
 ByteBuffer *readFile( const char *filename )
 {
-    // construct a file pointer to read in binary mode
-    FILE *fp = fopen( filename, "rb" );
+    int fd = open( filename, O_RDONLY );
 
     // if we could not open that passed filename, return NULL
-    if( !fp ){
+    if( fd < 0 ){
         return NULL;
     }
 
     // construct our ByteBuffer
-    ByteBuffer * buffer = createBuffer();
-
-    // seek to the end of the file
-    fseek( fp, 0, SEEK_END );
-
-    // get the current location in the file = file length
-    long length = ftell( fp );
+    ByteBuffer *buffer = createBuffer();
 
-    // rewind to the start of the file
-    rewind( fp );
-
-    // create an array of bytes with size of length + 1
-    byte bufferArray[ length ];
-
-    // read file contents in to buffer using fread()
-    fread( bufferArray, sizeof( byte ), sizeof( bufferArray ) / sizeof( byte ), fp);
-
-    // save the length of the bufferArray for our for loop
-    int byteArrayLen = sizeof( bufferArray ) / sizeof( byte );
+    // if we know how big the file is, make room for all of it at once
+    struct stat st;
+    if( fstat( fd, &st ) == 0 && S_ISREG( st.st_mode ) && st.st_size > 0 ){
+        reserve( buffer, st.st_size + PAD_ROOM );
+    }
 
-    // copy contents of bufferArray in to our buffer by passing to addByte()
-    for( int i = 0; i < byteArrayLen; i++ ) {
-        addByte( buffer, bufferArray[ i ] );
+    while( 1 ){
+        // out of room, the file isn't a regular file or it's grown
+        if( buffer->len == buffer->cap ){
+            reserve( buffer, READ_CHUNK );
+        }
+
+        size_t want = buffer->cap - buffer->len;
+        if( want > READ_LIMIT ){
+            want = READ_LIMIT;
+        }
+
+        ssize_t n = read( fd, buffer->data + buffer->len, want );
+        if( n == 0 ){
+            break;
+        }
+
+        if( n < 0 ){
+            if( errno == EINTR ){
+                continue;
+            }
+
+            // give up, keeping errno from the failed read
+            int err = errno;
+            freeBuffer( buffer );
+            close( fd );
+            errno = err;
+            return NULL;
+        }
+
+        buffer->len += n;
     }
 
-    // close fp
-    fclose( fp );
+    close( fd );
 
     // return buffer
     return buffer;
@@ -10,6 +10,8 @@
 /** Define our byte buffer */
 #define _BYTE_BUFFER_H_
 
+#include <stddef.h>
+
 /** Number of bits in a byte */
 #define BBITS 8
 
@@ -22,6 +24,17 @@
 /** Initial capacity for buffer */
 #define INITIAL_CAPACITY 5
 
+/** Extra room readFile() leaves after the contents of a file, enough for the
+    most bytes padBuffer() can add, so padding never has to grow the buffer */
+#define PAD_ROOM 72
+
+/** Most bytes readFile() asks for in one read() call */
+#define READ_LIMIT ( 1 << 30 )
+
+/** Smallest amount readFile() grows a buffer by when the file's size isn't
+    known ahead of time, like for a pipe */
+#define READ_CHUNK ( 64 * 1024 )
+
 /** Type used as a byte. */
 typedef unsigned char byte;
 
@@ -33,16 +46,22 @@ typedef struct {
   byte *data;
 
   /** Number of currently used bytes in the data array. */
-  unsigned int len;
+  size_t len;
 
   /** Capacity of the data array (it's typically over-allocated. */
-  unsigned int cap;
+  size_t cap;
 } ByteBuffer;
 
 /** createBuffer() function prototype */
 ByteBuffer *createBuffer();
 /** addByte() function prototype */
 void addByte( ByteBuffer *buffer, byte b );
+/** reserve() function prototype */
+void reserve( ByteBuffer *buffer, size_t n );
+/** appendBytes() function prototype */
+void appendBytes( ByteBuffer *buffer, byte const *src, size_t n );
+/** appendFill() function prototype */
+void appendFill( ByteBuffer *buffer, byte b, size_t n );
 /** freeBuffer() function prototype */
 void freeBuffer( ByteBuffer *buffer );
 /** readFile() function prototype */
@@ -0,0 +1,164 @@
+/**
+ * @file checkHash.c
+ * @author Jake Donovan (jmpatte8)
+ * This file is responsible for checking files against a manifest.  Every file in the manifest is
+ * hashed by the worker pool, reading it a chunk at a time, and only the files that don't match are
+ * reported, followed by a summary.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "checkHash.h"
+#include "fileHash.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+/** The entries of a manifest and how checking them went */
+typedef struct {
+  /** Path of each file */
+  char **paths;
+
+  /** Expected hash of each file, as lowercase hex digits */
+  char ( *digests )[ HASH_CHARS + 1 ];
+
+  /** Number of entries */
+  int count;
+
+  /** Capacity of the arrays */
+  int cap;
+
+  /** Number of files that matched */
+  int matched;
+
+  /** Number of files that didn't match */
+  int failed;
+
+  /** Number of files that couldn't be read */
+  int unreadable;
+} Manifest;
+
+/**
+ * This function parses one line of a manifest, a hash, two spaces (or a space and a '*', for binary
+ * mode) and a path, and adds it to the manifest
+ * @param m the manifest
+ * @param line the line, without its newline
+ * @return true if the line was in the right format
+*/
+static bool parseLine( Manifest *m, char const *line )
+{
+  for( int i = 0; i < HASH_CHARS; i++ ){
+    if( !isxdigit( ( unsigned char )line[ i ] ) ){
+      return false;
+    }
+  }
+
+  char const *path = line + HASH_CHARS + 2;
+  if( line[ HASH_CHARS ] != ' ' || ( line[ HASH_CHARS + 1 ] != ' ' && line[ HASH_CHARS + 1 ] != '*' ) ||
+      *path == '\0' ){
+    return false;
+  }
+
+  if( m->count == m->cap ){
+    m->cap *= 2;
+    m->paths = ( char ** )realloc( m->paths, m->cap * sizeof( char * ) );
+    m->digests = realloc( m->digests, m->cap * sizeof( *m->digests ) );
+  }
+
+  for( int i = 0; i < HASH_CHARS; i++ ){
+    m->digests[ m->count ][ i ] = tolower( ( unsigned char )line[ i ] );
+  }
+  m->digests[ m->count ][ HASH_CHARS ] = '\0';
+  m->paths[ m->count ] = strdup( path );
+  m->count++;
+  return true;
+}
+
+/**
+ * This function compares a file's hash to the manifest, reporting it if it's different or couldn't be
+ * read.  It's called by hashAll() in manifest order
+ * @param i index of the file
+ * @param state the file's hash
+ * @param err zero, or the errno value for why the file couldn't be read
+ * @param arg the manifest
+*/
+static void checkEntry( int i, HashState *state, int err, void *arg )
+{
+  Manifest *m = ( Manifest * )arg;
+
+  if( err ){
+    printf( "%s: FAILED open or read\n", m->paths[ i ] );
+    fflush( stdout );
+    fprintf( stderr, "%s: %s\n", m->paths[ i ], strerror( err ) );
+    m->unreadable++;
+    return;
+  }
+
+  char str[ HASH_CHARS + 1 ];
+  hashString( state, str );
+  if( strcmp( str, m->digests[ i ] ) == 0 ){
+    m->matched++;
+  } else {
+    printf( "%s: FAILED\n", m->paths[ i ] );
+    m->failed++;
+  }
+}
+
+/**
+ * This function checks every file listed in a manifest.  Files that don't match are printed with
+ * FAILED, lines that aren't in the right format are reported on standard error, and a summary is
+ * printed at the end
+ * @param manifest name of the manifest file
+ * @return program exit status, success only if every file matched
+*/
+int checkManifest( char const *manifest )
+{
+  FILE *fp = fopen( manifest, "r" );
+  if( fp == NULL ){
+    perror( manifest );
+    return EXIT_FAILURE;
+  }
+
+  Manifest m;
+  m.count = 0;
+  m.cap = MANIFEST_CAPACITY;
+  m.paths = ( char ** )malloc( m.cap * sizeof( char * ) );
+  m.digests = malloc( m.cap * sizeof( *m.digests ) );
+  m.matched = m.failed = m.unreadable = 0;
+
+  char *line = NULL;
+  size_t lineCap = 0;
+  ssize_t len;
+  int lineNo = 0, malformed = 0;
+  while( ( len = getline( &line, &lineCap, fp ) ) >= 0 ){
+    lineNo++;
+    if( len > 0 && line[ len - 1 ] == '\n' ){
+      line[ --len ] = '\0';
+    }
+
+    if( !parseLine( &m, line ) ){
+      fprintf( stderr, "%s:%d: improperly formatted line\n", manifest, lineNo );
+      malformed++;
+    }
+  }
+  free( line );
+  fclose( fp );
+
+  // stream every file, so a bad block is a read error instead of a crash
+  hashAll( m.paths, m.count, hashFileStream, checkEntry, &m );
+
+  printf( "checked %d files: %d OK, %d FAILED, %d unreadable\n", m.count, m.matched, m.failed,
+          m.unreadable );
+  if( malformed ){
+    printf( "%d improperly formatted lines\n", malformed );
+  }
+
+  for( int i = 0; i < m.count; i++ ){
+    free( m.paths[ i ] );
+  }
+  free( m.paths );
+  free( m.digests );
+
+  return m.matched == m.count && malformed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,18 @@
+/**
+ * @file checkHash.h
+ * @author Jake Donovan (jmpatte8)
+ * This header file is for checking files against a manifest of "digest  path" lines, like the ones
+ * hash prints for more than one file.
+*/
+
+#ifndef _CHECK_HASH_H_
+/** Our manifest checking header */
+#define _CHECK_HASH_H_
+
+/** Initial number of lines a manifest can hold */
+#define MANIFEST_CAPACITY 256
+
+/** checkManifest function prototype */
+int checkManifest( char const *manifest );
+
+#endif
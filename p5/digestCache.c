@@ -0,0 +1,475 @@
+/**
+ * @file digestCache.c
+ * @author Jake Donovan (jmpatte8)
+ * This file is responsible for the persistent digest cache.  The saved cache is mapped read-only when
+ * it's opened, so any number of worker threads can search it at once.  Files that miss are hashed and
+ * collected in memory, and cacheClose() merges them into a new cache file, which replaces the old one
+ * in a single rename.  The merge drops saved records that are stale, because the same file has a new
+ * record, and if the cache has gotten too big, saved records for files this run didn't see.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "digestCache.h"
+#include "fileHash.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/** Marks the start of a cache file, and tells us it was written with this byte order */
+#define CACHE_MAGIC 0x43444d52u
+
+/** Version of the cache file format */
+#define CACHE_VERSION 1
+
+/** Start of a cache file */
+typedef struct {
+  /** Always CACHE_MAGIC */
+  uint32_t magic;
+
+  /** Always CACHE_VERSION */
+  uint32_t version;
+
+  /** Number of records after the header */
+  uint64_t count;
+} CacheHeader;
+
+/** One cached file, identified by its metadata */
+typedef struct {
+  /** Device the file is on */
+  uint64_t dev;
+
+  /** Inode number of the file */
+  uint64_t ino;
+
+  /** Size of the file */
+  uint64_t size;
+
+  /** Modification time of the file, in nanoseconds */
+  int64_t mtime;
+
+  /** Final hash state of the file */
+  HashState state;
+} CacheRecord;
+
+/** Name of the cache file, or NULL if the cache isn't open */
+static char *cachePath = NULL;
+
+/** Records in the saved cache, mapped from the file, or NULL if there aren't any */
+static CacheRecord const *saved = NULL;
+
+/** Number of saved records */
+static size_t savedCount = 0;
+
+/** Size of the mapping for the saved records */
+static size_t mapSize = 0;
+
+/** For each saved record, whether it was found by this run */
+static bool *savedUsed = NULL;
+
+/** True if the merge should drop saved records that weren't found by this run */
+static bool pruneUnused = false;
+
+/** Records for files that weren't in the saved cache */
+static CacheRecord *added = NULL;
+
+/** Number of new records */
+static size_t addedCount = 0;
+
+/** Capacity of the new records array */
+static size_t addedCap = 0;
+
+/** Number of files found in the cache */
+static int hits = 0;
+
+/** Number of files that had to be read */
+static int misses = 0;
+
+/** Lock for the new records and the statistics */
+static pthread_mutex_t cacheLock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * This function compares two records by their keys
+ * @param a the first record
+ * @param b the second record
+ * @return negative, zero or positive, like strcmp()
+*/
+static int compareKeys( CacheRecord const *a, CacheRecord const *b )
+{
+  if( a->dev != b->dev ){
+    return a->dev < b->dev ? -1 : 1;
+  }
+  if( a->ino != b->ino ){
+    return a->ino < b->ino ? -1 : 1;
+  }
+  if( a->size != b->size ){
+    return a->size < b->size ? -1 : 1;
+  }
+  if( a->mtime != b->mtime ){
+    return a->mtime < b->mtime ? -1 : 1;
+  }
+  return 0;
+}
+
+/**
+ * This function checks if two records are for the same file, maybe with different contents
+ * @param a the first record
+ * @param b the second record
+ * @return true if they have the same device and inode
+*/
+static bool sameFile( CacheRecord const *a, CacheRecord const *b )
+{
+  return a->dev == b->dev && a->ino == b->ino;
+}
+
+/**
+ * This function compares two records for qsort()
+ * @param a the first record
+ * @param b the second record
+ * @return negative, zero or positive, like strcmp()
+*/
+static int compareRecords( const void *a, const void *b )
+{
+  return compareKeys( ( CacheRecord const * )a, ( CacheRecord const * )b );
+}
+
+/**
+ * This function fills in the key of a record from a file's metadata
+ * @param rec the record
+ * @param st the file's metadata
+*/
+static void makeKey( CacheRecord *rec, struct stat const *st )
+{
+  memset( rec, 0, sizeof( *rec ) );
+  rec->dev = st->st_dev;
+  rec->ino = st->st_ino;
+  rec->size = st->st_size;
+  rec->mtime = ( int64_t )st->st_mtim.tv_sec * 1000000000LL + st->st_mtim.tv_nsec;
+}
+
+/**
+ * This function gives the name of the default cache file, the one named by the HASH_CACHE environment
+ * variable, or $HOME/.cache/ripemd-hash.cache, creating $HOME/.cache if needed
+ * @return the name, which the caller frees, or NULL if there's nowhere to put the cache
+*/
+char *cacheDefaultPath()
+{
+  char const *env = getenv( CACHE_ENV );
+  if( env && *env ){
+    return strdup( env );
+  }
+
+  char const *home = getenv( "HOME" );
+  if( home == NULL || *home == '\0' ){
+    return NULL;
+  }
+
+  char *path = ( char * )malloc( strlen( home ) + strlen( "/.cache/" CACHE_NAME ) + 1 );
+  strcpy( path, home );
+  strcat( path, "/.cache" );
+  mkdir( path, 0700 );
+  strcat( path, "/" CACHE_NAME );
+  return path;
+}
+
+/**
+ * This function opens the cache, mapping the saved records if the file exists and is valid.  A missing
+ * or damaged cache file just means starting with an empty cache
+ * @param path name of the cache file
+ * @return true, since the cache can always be used
+*/
+bool cacheOpen( char const *path )
+{
+  cachePath = strdup( path );
+
+  int fd = open( path, O_RDONLY );
+  if( fd < 0 ){
+    return true;
+  }
+
+  struct stat st;
+  CacheHeader header;
+  if( fstat( fd, &st ) == 0 && read( fd, &header, sizeof( header ) ) == sizeof( header ) &&
+      header.magic == CACHE_MAGIC && header.version == CACHE_VERSION && header.count > 0 &&
+      st.st_size == sizeof( header ) + header.count * sizeof( CacheRecord ) ){
+    void *map = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    if( map != MAP_FAILED ){
+      mapSize = st.st_size;
+      saved = ( CacheRecord const * )( ( byte const * )map + sizeof( header ) );
+      savedCount = header.count;
+      savedUsed = ( bool * )calloc( savedCount, sizeof( bool ) );
+    }
+  }
+
+  close( fd );
+  return true;
+}
+
+/**
+ * This function searches the saved records for a file
+ * @param key a record with the file's key
+ * @return the saved record, or NULL if there isn't one
+*/
+static CacheRecord const *findSaved( CacheRecord const *key )
+{
+  size_t lo = 0, hi = savedCount;
+  while( lo < hi ){
+    size_t mid = lo + ( hi - lo ) / 2;
+    int c = compareKeys( saved + mid, key );
+    if( c == 0 ){
+      return saved + mid;
+    }
+    if( c < 0 ){
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+ * This function gives the current time in nanoseconds, to compare with modification times
+ * @return the time
+*/
+static int64_t nowNs()
+{
+  struct timespec ts;
+  clock_gettime( CLOCK_REALTIME, &ts );
+  return ( int64_t )ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/**
+ * This function computes the hash of a whole file, like hashFile(), but returns the cached hash
+ * without reading the file if its device, inode, size and modification time match a cache entry.
+ * Otherwise it hashes the file and remembers the result, as long as the file didn't change while it
+ * was read and wasn't modified too recently to trust its modification time.  The file is opened with
+ * openFile(), so direct I/O applies here too.  It's safe to call from many threads at once
+ * @param path name of the file
+ * @param state the final hash state, ready for printHash()
+ * @return true if the file was hashed, or false with errno set if it couldn't be opened or read
+*/
+bool cachedHashFile( char const *path, HashState *state )
+{
+  int fd = openFile( path );
+  if( fd < 0 ){
+    return false;
+  }
+
+  struct stat before;
+  CacheRecord key;
+  bool keyed = fstat( fd, &before ) == 0 && S_ISREG( before.st_mode );
+  if( keyed ){
+    makeKey( &key, &before );
+    CacheRecord const *rec = findSaved( &key );
+    if( rec ){
+      *state = rec->state;
+      close( fd );
+
+      pthread_mutex_lock( &cacheLock );
+      hits++;
+      savedUsed[ rec - saved ] = true;
+      pthread_mutex_unlock( &cacheLock );
+      return true;
+    }
+  }
+
+  bool ok = hashFd( fd, state, true );
+  int err = errno;
+
+  struct stat after;
+  CacheRecord check;
+  keyed = keyed && ok && fstat( fd, &after ) == 0;
+  if( keyed ){
+    makeKey( &check, &after );
+    keyed = compareKeys( &key, &check ) == 0 && nowNs() - key.mtime >= RACY_NS;
+  }
+  close( fd );
+
+  pthread_mutex_lock( &cacheLock );
+  misses++;
+  if( keyed ){
+    if( addedCount == addedCap ){
+      addedCap = addedCap ? addedCap * 2 : CACHE_CAPACITY;
+      added = ( CacheRecord * )realloc( added, addedCap * sizeof( CacheRecord ) );
+    }
+    key.state = *state;
+    added[ addedCount++ ] = key;
+  }
+  pthread_mutex_unlock( &cacheLock );
+
+  errno = err;
+  return ok;
+}
+
+/**
+ * This function writes bytes to a file, stopping at the first error
+ * @param fd the file
+ * @param data the bytes to write
+ * @param len number of bytes
+ * @return true if they were all written
+*/
+static bool writeAll( int fd, void const *data, size_t len )
+{
+  byte const *p = ( byte const * )data;
+  while( len > 0 ){
+    ssize_t n = write( fd, p, len );
+    if( n < 0 ){
+      if( errno == EINTR ){
+        continue;
+      }
+      return false;
+    }
+    p += n;
+    len -= n;
+  }
+
+  return true;
+}
+
+/**
+ * This function checks if a saved record should be kept.  It's dropped if there's a new record for the
+ * same file, since the file has changed, or if the cache is being pruned and this run didn't find it.
+ * Records for the same file are next to each other in key order, so a new one for the file is either
+ * the next new record or the one just before it
+ * @param i index of the saved record
+ * @param j index of the next new record
+ * @return true if the record should be kept
+*/
+static bool keepSaved( size_t i, size_t j )
+{
+  if( j < addedCount && sameFile( saved + i, added + j ) ){
+    return false;
+  }
+  if( j > 0 && sameFile( saved + i, added + j - 1 ) ){
+    return false;
+  }
+  return !pruneUnused || savedUsed[ i ];
+}
+
+/**
+ * This function gives the next record in key order from the saved and new records, which are both
+ * sorted.  Saved records that shouldn't be kept are skipped
+ * @param i index of the next saved record, updated
+ * @param j index of the next new record, updated
+ * @return the record, or NULL if there are none left
+*/
+static CacheRecord const *nextMerged( size_t *i, size_t *j )
+{
+  while( *i < savedCount && !keepSaved( *i, *j ) ){
+    ( *i )++;
+  }
+
+  if( *i == savedCount && *j == addedCount ){
+    return NULL;
+  }
+
+  bool useSaved = *j == addedCount || ( *i < savedCount && compareKeys( saved + *i, added + *j ) < 0 );
+  return useSaved ? saved + ( *i )++ : added + ( *j )++;
+}
+
+/**
+ * This function counts the records a merge would write
+ * @return the number of records
+*/
+static size_t mergedCount()
+{
+  size_t i = 0, j = 0, total = 0;
+  while( nextMerged( &i, &j ) ){
+    total++;
+  }
+  return total;
+}
+
+/**
+ * This function saves the cache, if any files were added to it, and closes it.  The saved and new
+ * records are merged in key order into a temporary file, which is then renamed over the old cache, so
+ * another run never sees a partly written cache
+ * @return true if the cache was saved, or didn't need to be
+*/
+bool cacheClose()
+{
+  if( cachePath == NULL ){
+    return true;
+  }
+
+  bool ok = true;
+  if( addedCount > 0 ){
+    qsort( added, addedCount, sizeof( CacheRecord ), compareRecords );
+
+    // the same file can be named more than once, so drop duplicates
+    size_t unique = 1;
+    for( size_t j = 1; j < addedCount; j++ ){
+      if( compareKeys( added + unique - 1, added + j ) != 0 ){
+        added[ unique++ ] = added[ j ];
+      }
+    }
+    addedCount = unique;
+
+    char *tmp = ( char * )malloc( strlen( cachePath ) + 32 );
+    sprintf( tmp, "%s.%ld", cachePath, ( long )getpid() );
+    int fd = open( tmp, O_WRONLY | O_CREAT | O_TRUNC, 0600 );
+    ok = fd >= 0;
+
+    // if the cache has gotten too big, only keep what this run saw
+    size_t total = mergedCount();
+    if( total > CACHE_MAX_ENTRIES ){
+      pruneUnused = true;
+      total = mergedCount();
+    }
+
+    CacheHeader header = { CACHE_MAGIC, CACHE_VERSION, total };
+    ok = ok && writeAll( fd, &header, sizeof( header ) );
+
+    CacheRecord const *rec;
+    size_t i = 0, j = 0;
+    while( ok && ( rec = nextMerged( &i, &j ) ) ){
+      ok = writeAll( fd, rec, sizeof( CacheRecord ) );
+    }
+
+    if( fd >= 0 && close( fd ) != 0 ){
+      ok = false;
+    }
+    if( ok && rename( tmp, cachePath ) != 0 ){
+      ok = false;
+    }
+    if( !ok ){
+      perror( cachePath );
+      unlink( tmp );
+    }
+    free( tmp );
+  }
+
+  if( saved ){
+    munmap( ( byte * )saved - sizeof( CacheHeader ), mapSize );
+  }
+  free( added );
+  free( savedUsed );
+  free( cachePath );
+  saved = NULL;
+  savedUsed = NULL;
+  pruneUnused = false;
+  savedCount = addedCount = addedCap = 0;
+  added = NULL;
+  cachePath = NULL;
+  return ok;
+}
+
+/**
+ * This function prints statistics for the cache: how many files were found in it, how many had to be
+ * read, and how many entries it has
+ * @param fp where to print them
+*/
+void cacheStats( FILE *fp )
+{
+  fprintf( fp, "cache: %d hits, %d misses, %zu saved entries, %zu new\n", hits, misses, savedCount,
+           addedCount );
+}
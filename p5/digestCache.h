@@ -0,0 +1,47 @@
+/**
+ * @file digestCache.h
+ * @author Jake Donovan (jmpatte8)
+ * This header file is for the persistent digest cache.  The cache remembers the hash of every file
+ * it sees, keyed by the file's device, inode, size and modification time, so a file that hasn't
+ * changed since the last run doesn't have to be read again.  The cache file is a sorted array of
+ * fixed-size records that's memory-mapped and binary searched.  A file keeps only its newest entry,
+ * and the cache is capped at CACHE_MAX_ENTRIES, so it doesn't grow forever.
+*/
+
+#ifndef _DIGEST_CACHE_H_
+/** Our digest cache header */
+#define _DIGEST_CACHE_H_
+
+#include "ripeMD.h"
+#include <stdbool.h>
+#include <stdio.h>
+
+/** Environment variable naming the cache file */
+#define CACHE_ENV "HASH_CACHE"
+
+/** Name of the cache file under $HOME/.cache, if CACHE_ENV isn't set */
+#define CACHE_NAME "ripemd-hash.cache"
+
+/** Files modified less than this many nanoseconds ago aren't cached, since they could be changed
+    again without their modification time changing */
+#define RACY_NS 2000000000LL
+
+/** Initial number of new entries the cache can hold before it's saved */
+#define CACHE_CAPACITY 256
+
+/** Most entries the cache file keeps.  Past this, entries for files that weren't seen in the run
+    being saved are dropped */
+#define CACHE_MAX_ENTRIES 1000000
+
+/** cacheOpen function prototype */
+bool cacheOpen( char const *path );
+/** cacheDefaultPath function prototype */
+char *cacheDefaultPath();
+/** cachedHashFile function prototype */
+bool cachedHashFile( char const *path, HashState *state );
+/** cacheClose function prototype */
+bool cacheClose();
+/** cacheStats function prototype */
+void cacheStats( FILE *fp );
+
+#endif
@@ -0,0 +1,494 @@
+/**
+ * @file fileHash.c
+ * @author Jake Donovan (jmpatte8)
+ * This file is responsible for hashing whole files.  It tells the kernel each file will be read
+ * straight through, so it can read ahead of the hashing.  It also has the worker pool that hashes
+ * many files at once and reports the results in order.  Big files are read by a second thread, into
+ * a ring of buffers, so reading the next piece of the file overlaps with hashing this one.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+// O_DIRECT is a Linux extension
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+
+#include "fileHash.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/** True if files are opened with O_DIRECT, bypassing the page cache */
+static bool directIO = false;
+
+/** A ring of buffers that a reader thread fills from a file and the hashing thread empties */
+typedef struct {
+  /** The file being read */
+  int fd;
+
+  /** The buffers, each PIPE_BYTES long and aligned for direct I/O */
+  byte *buf[ PIPE_BUFFERS ];
+
+  /** Number of bytes read into each buffer */
+  size_t len[ PIPE_BUFFERS ];
+
+  /** Number of buffers the reader has filled so far */
+  unsigned long filled;
+
+  /** Number of buffers the hashing thread has finished with */
+  unsigned long hashed;
+
+  /** True once the reader reaches the end of the file or an error */
+  bool ended;
+
+  /** True if the hashing thread wants the reader to stop */
+  bool stop;
+
+  /** Zero, or the errno value for the read that failed */
+  int err;
+
+  /** Lock for everything but the buffers themselves */
+  pthread_mutex_t lock;
+
+  /** Signaled when a buffer is filled or the reader ends */
+  pthread_cond_t ready;
+
+  /** Signaled when a buffer is free */
+  pthread_cond_t space;
+} Pipe;
+
+/**
+ * This function turns direct I/O on or off.  With it on, files are read with O_DIRECT, where the
+ * system supports it, and never mapped, so hashing a big tree doesn't push everything else out of
+ * the page cache
+ * @param on true to use direct I/O
+*/
+void setDirectIO( bool on )
+{
+  directIO = on;
+}
+
+/**
+ * This function is the start routine for the reader thread.  It fills each free buffer in the ring
+ * with the next part of the file, until the end of the file, an error, or the hashing thread stops it
+ * @param arg the pipe
+ * @return NULL
+*/
+static void *reader( void *arg )
+{
+  Pipe *p = ( Pipe * )arg;
+
+  while( 1 ){
+    pthread_mutex_lock( &p->lock );
+    while( p->filled - p->hashed == PIPE_BUFFERS && !p->stop ){
+      pthread_cond_wait( &p->space, &p->lock );
+    }
+    bool stop = p->stop;
+    int slot = p->filled % PIPE_BUFFERS;
+    pthread_mutex_unlock( &p->lock );
+
+    if( stop ){
+      return NULL;
+    }
+
+    // fill the whole buffer, so the next direct read starts at an aligned offset
+    size_t len = 0;
+    ssize_t n = 1;
+    while( len < PIPE_BYTES ){
+      n = read( p->fd, p->buf[ slot ] + len, PIPE_BYTES - len );
+      if( n < 0 && errno == EINTR ){
+        continue;
+      }
+      if( n <= 0 ){
+        break;
+      }
+      len += n;
+    }
+
+    pthread_mutex_lock( &p->lock );
+    if( len > 0 ){
+      p->len[ slot ] = len;
+      p->filled++;
+    }
+    if( n <= 0 ){
+      p->ended = true;
+      p->err = n < 0 ? errno : 0;
+    }
+    pthread_cond_signal( &p->ready );
+    pthread_mutex_unlock( &p->lock );
+
+    if( n <= 0 ){
+      return NULL;
+    }
+  }
+}
+
+/**
+ * This function hashes a file with a reader thread, so the disk and the processor are both kept busy.
+ * The reader fills a ring of PIPE_BUFFERS buffers while this thread hashes the ones that are full
+ * @param fd the open file
+ * @param ctx the streaming context to add the file to
+ * @return true if the whole file was read, or false with errno set if there was an error
+*/
+static bool hashPipelined( int fd, RipeCtx *ctx )
+{
+  Pipe p;
+  p.fd = fd;
+  p.filled = p.hashed = 0;
+  p.ended = p.stop = false;
+  p.err = 0;
+  for( int i = 0; i < PIPE_BUFFERS; i++ ){
+    void *buf = NULL;
+    int err = posix_memalign( &buf, PIPE_ALIGN, PIPE_BYTES );
+    if( err != 0 ){
+      while( i > 0 ){
+        free( p.buf[ --i ] );
+      }
+      errno = err;
+      return false;
+    }
+    p.buf[ i ] = ( byte * )buf;
+  }
+  pthread_mutex_init( &p.lock, NULL );
+  pthread_cond_init( &p.ready, NULL );
+  pthread_cond_init( &p.space, NULL );
+
+  pthread_t thread;
+  if( pthread_create( &thread, NULL, reader, &p ) != 0 ){
+    fprintf( stderr, "Can't create thread\n" );
+    exit( EXIT_FAILURE );
+  }
+
+  while( 1 ){
+    pthread_mutex_lock( &p.lock );
+    while( p.filled == p.hashed && !p.ended ){
+      pthread_cond_wait( &p.ready, &p.lock );
+    }
+
+    // stop at an error right away, without hashing what's left in the ring
+    bool done = p.err != 0 || p.filled == p.hashed;
+    int slot = p.hashed % PIPE_BUFFERS;
+    pthread_mutex_unlock( &p.lock );
+
+    if( done ){
+      break;
+    }
+
+    ripeUpdate( ctx, p.buf[ slot ], p.len[ slot ] );
+
+    pthread_mutex_lock( &p.lock );
+    p.hashed++;
+    pthread_cond_signal( &p.space );
+    pthread_mutex_unlock( &p.lock );
+  }
+
+  pthread_mutex_lock( &p.lock );
+  p.stop = true;
+  pthread_cond_signal( &p.space );
+  pthread_mutex_unlock( &p.lock );
+  pthread_join( thread, NULL );
+
+  for( int i = 0; i < PIPE_BUFFERS; i++ ){
+    free( p.buf[ i ] );
+  }
+  pthread_cond_destroy( &p.space );
+  pthread_cond_destroy( &p.ready );
+  pthread_mutex_destroy( &p.lock );
+
+  if( p.err ){
+    errno = p.err;
+    return false;
+  }
+  return true;
+}
+
+/**
+ * This function hashes a memory-mapped file
+ * @param fd the open file
+ * @param size the size of the file
+ * @param ctx the streaming context to add the file to
+ * @return true if the file could be mapped
+*/
+static bool hashMapped( int fd, size_t size, RipeCtx *ctx )
+{
+  byte *map = ( byte * )mmap( NULL, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+  if( map == MAP_FAILED ){
+    return false;
+  }
+
+  posix_madvise( map, size, POSIX_MADV_SEQUENTIAL );
+  ripeUpdate( ctx, map, size );
+  munmap( map, size );
+  return true;
+}
+
+/**
+ * This function hashes a file by reading it a chunk at a time, until the end
+ * @param fd the open file
+ * @param ctx the streaming context to add the file to
+ * @return true if the whole file was read, or false with errno set if there was an error
+*/
+static bool hashRead( int fd, RipeCtx *ctx )
+{
+  // aligned, in case the file was opened for direct I/O
+  void *chunk;
+  int err = posix_memalign( &chunk, PIPE_ALIGN, READ_BYTES );
+  if( err != 0 ){
+    errno = err;
+    return false;
+  }
+  bool ok = true;
+
+  while( 1 ){
+    ssize_t n = read( fd, chunk, READ_BYTES );
+    if( n == 0 ){
+      break;
+    }
+
+    if( n < 0 ){
+      if( errno == EINTR ){
+        continue;
+      }
+      ok = false;
+      break;
+    }
+
+    ripeUpdate( ctx, chunk, n );
+  }
+
+  err = errno;
+  free( chunk );
+  errno = err;
+  return ok;
+}
+
+/**
+ * This function computes the hash of an open file, from the current position to the end.  A big
+ * regular file is mapped into memory, if that's allowed; otherwise big files and pipes are read by a
+ * separate thread while they're hashed, and small files are just read a chunk at a time
+ * @param fd the open file
+ * @param state the final hash state
+ * @param map true if a big regular file can be mapped
+ * @return true if the file was hashed, or false with errno set if it couldn't be read
+*/
+bool hashFd( int fd, HashState *state, bool map )
+{
+  RipeCtx ctx;
+  ripeInit( &ctx );
+
+  struct stat st;
+  bool regular = fstat( fd, &st ) == 0 && S_ISREG( st.st_mode );
+  bool big = !regular || st.st_size >= PIPE_MIN;
+
+  if( !( map && !directIO && regular && st.st_size >= MAP_MIN && hashMapped( fd, st.st_size, &ctx ) ) ){
+    // the file's read from start to finish, so ask for aggressive readahead
+    posix_fadvise( fd, 0, 0, POSIX_FADV_SEQUENTIAL );
+
+    // a reader thread isn't worth starting for a small file
+    if( !( big ? hashPipelined( fd, &ctx ) : hashRead( fd, &ctx ) ) ){
+      return false;
+    }
+  }
+
+  ripeFinal( &ctx, state );
+  return true;
+}
+
+/**
+ * This function opens a file to be hashed, with O_DIRECT if direct I/O is on and the file system
+ * supports it
+ * @param path name of the file
+ * @return the file descriptor, or -1 with errno set if the file couldn't be opened
+*/
+int openFile( char const *path )
+{
+  int fd = -1;
+#ifdef O_DIRECT
+  if( directIO ){
+    fd = open( path, O_RDONLY | O_DIRECT );
+  }
+#endif
+
+  // not every file system supports direct I/O, so fall back to reading normally
+  if( fd < 0 ){
+    fd = open( path, O_RDONLY );
+  }
+  return fd;
+}
+
+/**
+ * This function computes the hash of a whole file by name
+ * @param path name of the file
+ * @param state the final hash state
+ * @param map true if a big regular file can be mapped
+ * @return true if the file was hashed, or false with errno set if it couldn't be opened or read
+*/
+static bool hashPath( char const *path, HashState *state, bool map )
+{
+  int fd = openFile( path );
+  if( fd < 0 ){
+    return false;
+  }
+
+  bool ok = hashFd( fd, state, map );
+  int err = errno;
+  close( fd );
+  errno = err;
+  return ok;
+}
+
+/**
+ * This function computes the hash of a whole file. Regular files of at least MAP_MIN bytes are mapped
+ * into memory and hashed in place, and anything else, including pipes, is read a chunk at a time
+ * @param path name of the file
+ * @param state the final hash state, ready for printHash()
+ * @return true if the file was hashed, or false with errno set if it couldn't be opened or read
+*/
+bool hashFile( char const *path, HashState *state )
+{
+  return hashPath( path, state, true );
+}
+
+/**
+ * This function computes the hash of a whole file, always reading it a chunk at a time.  It's a little
+ * slower than hashFile() for big files, but a read error stops the file right there and is reported,
+ * where touching a bad page of a mapped file would kill the program
+ * @param path name of the file
+ * @param state the final hash state, ready for printHash()
+ * @return true if the file was hashed, or false with errno set if it couldn't be opened or read
+*/
+bool hashFileStream( char const *path, HashState *state )
+{
+  return hashPath( path, state, false );
+}
+
+/** Result of hashing one of the files given to hashAll() */
+typedef struct {
+  /** Final hash state, if the file was hashed */
+  HashState state;
+
+  /** Zero if the file was hashed, or the errno value saying why it wasn't */
+  int err;
+
+  /** True once a worker has finished with the file */
+  bool done;
+} Result;
+
+/** Files to hash and what happened to each one, shared by the workers */
+typedef struct {
+  /** Names of the files */
+  char **paths;
+
+  /** One result for each file */
+  Result *results;
+
+  /** Number of files */
+  int count;
+
+  /** Function that hashes each file */
+  FileHasher hasher;
+
+  /** Index of the next file for a worker to take */
+  int next;
+
+  /** Lock for next and for the done flags */
+  pthread_mutex_t lock;
+
+  /** Signaled whenever a file is done */
+  pthread_cond_t finished;
+} Work;
+
+/**
+ * This function is the start routine for each worker thread. It takes the next file that nobody
+ * has started on, hashes it and records the result, until there are no files left.  Since files
+ * are handed out one at a time, a big file only keeps one worker busy while the rest move on
+ * @param arg the shared work list
+ * @return NULL
+*/
+static void *worker( void *arg )
+{
+  Work *work = ( Work * )arg;
+
+  while( 1 ){
+    pthread_mutex_lock( &work->lock );
+    int i = work->next++;
+    pthread_mutex_unlock( &work->lock );
+
+    if( i >= work->count ){
+      return NULL;
+    }
+
+    Result *r = work->results + i;
+    int err = work->hasher( work->paths[ i ], &r->state ) ? 0 : errno;
+
+    pthread_mutex_lock( &work->lock );
+    r->err = err;
+    r->done = true;
+    pthread_cond_broadcast( &work->finished );
+    pthread_mutex_unlock( &work->lock );
+  }
+}
+
+/**
+ * This function hashes a list of files with a pool of worker threads, one for each core but no more
+ * than there are files.  The report function is called on this thread for each file, in order, as
+ * soon as it and every file before it are done
+ * @param paths names of the files
+ * @param count number of files
+ * @param hasher function that hashes each file, like hashFile()
+ * @param report function called with each file's result
+ * @param arg passed along to report
+*/
+void hashAll( char **paths, int count, FileHasher hasher, HashReport report, void *arg )
+{
+  Work work;
+  work.paths = paths;
+  work.count = count;
+  work.hasher = hasher;
+  work.next = 0;
+  work.results = ( Result * )calloc( count, sizeof( Result ) );
+  pthread_mutex_init( &work.lock, NULL );
+  pthread_cond_init( &work.finished, NULL );
+
+  long cores = sysconf( _SC_NPROCESSORS_ONLN );
+  int workers = cores < 1 ? 1 : cores;
+  if( workers > count ){
+    workers = count;
+  }
+
+  pthread_t *threads = ( pthread_t * )malloc( workers * sizeof( pthread_t ) );
+  for( int i = 0; i < workers; i++ ){
+    if( pthread_create( threads + i, NULL, worker, &work ) != 0 ){
+      fprintf( stderr, "Can't create thread\n" );
+      exit( EXIT_FAILURE );
+    }
+  }
+
+  // report the results in order, waiting for each one in turn
+  for( int i = 0; i < count; i++ ){
+    Result *r = work.results + i;
+
+    pthread_mutex_lock( &work.lock );
+    while( !r->done ){
+      pthread_cond_wait( &work.finished, &work.lock );
+    }
+    pthread_mutex_unlock( &work.lock );
+
+    report( i, &r->state, r->err, arg );
+  }
+
+  for( int i = 0; i < workers; i++ ){
+    pthread_join( threads[ i ], NULL );
+  }
+
+  pthread_cond_destroy( &work.finished );
+  pthread_mutex_destroy( &work.lock );
+  free( threads );
+  free( work.results );
+}
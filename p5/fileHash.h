@@ -0,0 +1,54 @@
+/**
+ * @file fileHash.h
+ * @author Jake Donovan (jmpatte8)
+ * This header file is for hashing whole files with the streaming functions.  Big regular files are
+ * memory-mapped and everything else is read in fixed-size chunks, so memory use never depends on the
+ * size of the file.  hashAll() hashes a list of files with a pool of threads.
+*/
+
+#ifndef _FILE_HASH_H_
+/** Our file hashing header */
+#define _FILE_HASH_H_
+
+#include "ripeMD.h"
+#include <stdbool.h>
+
+/** Number of bytes read from a file at a time */
+#define READ_BYTES ( 64 * 1024 )
+
+/** Smallest regular file that's memory-mapped instead of read */
+#define MAP_MIN ( 1024 * 1024 )
+
+/** Smallest regular file that's read by a separate thread, while it's hashed */
+#define PIPE_MIN ( 256 * 1024 )
+
+/** Number of buffers in the ring between the reader thread and the hashing thread */
+#define PIPE_BUFFERS 4
+
+/** Size of each buffer in the ring */
+#define PIPE_BYTES ( 1024 * 1024 )
+
+/** Alignment of the buffers in the ring, enough for direct I/O */
+#define PIPE_ALIGN 4096
+
+/** Type for a function that hashes a whole file, like hashFile() */
+typedef bool (*FileHasher)( char const *path, HashState *state );
+
+/** Type for a function hashAll() calls with each file's result, in order.  It gets the file's index,
+    its hash state, zero or the errno value saying why it couldn't be hashed, and hashAll()'s arg */
+typedef void (*HashReport)( int i, HashState *state, int err, void *arg );
+
+/** setDirectIO function prototype */
+void setDirectIO( bool on );
+/** openFile function prototype */
+int openFile( char const *path );
+/** hashFd function prototype */
+bool hashFd( int fd, HashState *state, bool map );
+/** hashFile function prototype */
+bool hashFile( char const *path, HashState *state );
+/** hashFileStream function prototype */
+bool hashFileStream( char const *path, HashState *state );
+/** hashAll function prototype */
+void hashAll( char **paths, int count, FileHasher hasher, HashReport report, void *arg );
+
+#endif
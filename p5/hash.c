@@ -2,75 +2,132 @@
  * @file hash.c
  * @author Jake Donovan (jmpatte8)
  * This is the main component. It contains the main function and uses the other components
- * to read the input file and to perform the RIPEMD computation.
+ * to read the input files and to perform the RIPEMD computation.  Files are hashed by a pool
+ * of worker threads, one for each core, and the results are printed in the order the files
+ * were given.  With -r, whole directory trees are hashed instead, and with -c, the files in a
+ * manifest are checked.  Hashes are remembered in a digest cache between runs, unless --no-cache
+ * is given.  With --hash160, a file of fixed-size records is hashed with HASH160 instead.
 */
 
-#include "byteBuffer.h"
-#include "ripeMD.h"
+#include "fileHash.h"
+#include "treeHash.h"
+#include "checkHash.h"
+#include "digestCache.h"
+#include "hash160.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 
+/** Number of files that couldn't be hashed */
+static int failures = 0;
+
 /**
- * This function calls byteBuffer.c functions and ripeMD.c functions to
- * read an input file and perform RipeMD computation
+ * This function prints the result for one of the files, the hash alone if it's the only file, or
+ * followed by its name if there are more.  It's called by hashAll() in the order the files were given
+ * @param i index of the file
+ * @param state the file's hash
+ * @param err zero, or the errno value for why the file couldn't be read
+ * @param arg the command-line arguments, starting with the first file
+*/
+static void printResult( int i, HashState *state, int err, void *arg )
+{
+  char **paths = ( char ** )arg;
+
+  if( err ){
+    fflush( stdout );
+    fprintf( stderr, "%s: %s\n", paths[ i ], strerror( err ) );
+    failures++;
+  } else if( i == 0 && paths[ 1 ] == NULL ){
+    printHash( state );
+  } else {
+    char str[ HASH_CHARS + 1 ];
+    hashString( state, str );
+    printf( "%s  %s\n", str, paths[ i ] );
+  }
+}
+
+/**
+ * This function hashes every file named on the command line with a pool of worker threads, and
+ * prints each file's hash as soon as it and every file before it are done.  With a single file,
+ * just the hash is printed, the same as always; with more, each hash is followed by the file name.
+ * If the first argument is -r, the rest name directories, and hashTree() hashes everything in them.
+ * If it's -c, the next one names a manifest, and checkManifest() checks the files in it.  Before
+ * any of these, --no-cache turns off the digest cache, --cache-stats reports how it did, and
+ * --direct reads files with direct I/O.  --hash160 takes a record size and an optional file, and
+ * hands them to hash160Batch()
  * @param argc the number of command-line arguments
  * @param argv an array of pointers to command line arguments as strings
  * @return program exit status
 */
 int main( int argc, char *argv[] )
 {
-  // the hash program expects one command line argument
-  // if we don't have one command line, print to stderr and
-  // terminate the program.
-  if( argc != MIN_ARGS ){
-    fprintf( stderr, "usage: hash <input-file>\n" );
-    exit( EXIT_FAILURE );
-  }
-
-  // pass filename to readFile() in byteBuffer.c to construct a new ByteBuffer
-  ByteBuffer *buffer = readFile( argv[1] );
+  // batch HASH160 of fixed-size records, from a file or standard input
+  if( argc > 1 && strcmp( argv[ 1 ], "--hash160" ) == 0 ){
+    char *end;
+    unsigned long recordLen = argc > 2 ? strtoul( argv[ 2 ], &end, 10 ) : 0;
+    if( argc < 3 || argc > 4 || *end != '\0' || recordLen == 0 || recordLen > HASH160_MAX_RECORD ){
+      fprintf( stderr, "usage: hash --hash160 <record-bytes> [<file>]\n" );
+      exit( EXIT_FAILURE );
+    }
 
-  // if readFile() returns null, that means the file could not be opened so we need to throw an error using perror() and exit unsuccessfully
-  if( buffer == NULL ){
-     perror( argv[1] );
-     exit( EXIT_FAILURE );
+    return hash160Batch( argc == 4 ? argv[ 3 ] : NULL, recordLen );
   }
 
-  // pad our buffer with spaces by calling padBuffer() until we have a multiple of 
-  padBuffer( buffer );
-
-  // construct a new HashState
-  HashState *state = ( HashState * )malloc( sizeof( HashState ) );
-  // initialize the newly constructed HashState fields
-  initState( state );
+  bool useCache = true, stats = false;
+  while( argc > 1 && strncmp( argv[ 1 ], "--", 2 ) == 0 ){
+    if( strcmp( argv[ 1 ], "--no-cache" ) == 0 ){
+      useCache = false;
+    } else if( strcmp( argv[ 1 ], "--cache-stats" ) == 0 ){
+      stats = true;
+    } else if( strcmp( argv[ 1 ], "--direct" ) == 0 ){
+      setDirectIO( true );
+    } else {
+      argc = 0;
+      break;
+    }
+    argv++;
+    argc--;
+  }
 
-  // file length variable so we can loop through each 64 byte chunks in our buffer
-  int allByte = 0;
+  // the hash program expects at least one command line argument
+  // if we don't have one, print to stderr and terminate the program.
+  bool tree = argc > 1 && strcmp( argv[ 1 ], "-r" ) == 0;
+  bool check = argc > 1 && strcmp( argv[ 1 ], "-c" ) == 0;
+  if( argc < MIN_ARGS + tree || ( check && argc != MIN_ARGS + 1 ) ){
+    fprintf( stderr, "usage: hash [--no-cache] [--cache-stats] [--direct] <input-file>...\n"
+             "       hash [--no-cache] [--cache-stats] [--direct] -r <directory>...\n"
+             "       hash [--direct] -c <manifest>\n"
+             "       hash --hash160 <record-bytes> [<file>]\n" );
+    exit( EXIT_FAILURE );
+  }
 
-  while( allByte < buffer->len ){
-      // use memcpy to get the first 64 bytes from our buffer
-      // construct a byte array
-      byte cpy[ BLOCK_BYTES ] = {};
-      // copy 64 bytes use allByte to shift to the correct spot in our buffer byte array
-      // so we can pass the correct 64-byte chunk of our buffer's byte array (this is in the case)
-      // that our buffer is larger than 64 bytes
-      memcpy( cpy, buffer->data + allByte, BLOCK_BYTES * sizeof( byte ) );
-      // pass our constructed and initialized state and our 64 byte array to hashBlock()
-      hashBlock( state, cpy );
-      // increment allByte by chunks of 64 as we know our buffer has a length that is a multiple of 64
-      allByte += BLOCK_BYTES;
+  // checking always reads the files, since the point is to find ones that went bad
+  if( check ){
+    return checkManifest( argv[ 2 ] );
   }
 
-  // print final state by call printHash()
-  printHash( state );
+  FileHasher hasher = hashFile;
+  char *cachePath = useCache ? cacheDefaultPath() : NULL;
+  if( cachePath && cacheOpen( cachePath ) ){
+    hasher = cachedHashFile;
+  }
+  free( cachePath );
 
-  // free our buffer memory
-  freeBuffer( buffer );
+  int status;
+  if( tree ){
+    status = hashTree( argv + 2, argc - 2, hasher );
+  } else {
+    hashAll( argv + 1, argc - 1, hasher, printResult, argv + 1 );
+    status = failures ? EXIT_FAILURE : EXIT_SUCCESS;
+  }
 
-  // free initial state
-  free( state );
+  if( hasher == cachedHashFile ){
+    if( stats ){
+      fflush( stdout );
+      cacheStats( stderr );
+    }
+    cacheClose();
+  }
 
-  // return successfully
-  return EXIT_SUCCESS;
+  return status;
 }
@@ -0,0 +1,271 @@
+/**
+ * @file hash160.c
+ * @author Jake Donovan (jmpatte8)
+ * This file is responsible for HASH160.  The RIPEMD-160 half always hashes a 32-byte SHA-256
+ * digest, so it's a single block whose padding is known at compile time.  In a batch, every record
+ * is the same size, so a record short enough for one SHA-256 block gets padding built once for the
+ * whole batch, and the SHA-256 digests for a whole batch go through the multi-buffer engine
+ * together.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "hash160.h"
+#include "ripeMulti.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/** The RIPEMD-160 block for a 32-byte message, except for the message: a 0x80 byte after it, zeros,
+    and the length, 256 bits, low-order byte first */
+static byte const ripePadded[ BLOCK_BYTES ] = {
+  [ SHA_DIGEST_BYTES ] = 0x80,
+  [ BLOCK_BYTES - BBITS + 1 ] = ( SHA_DIGEST_BYTES * BBITS ) >> BBITS
+};
+
+/**
+ * This function writes out a final RIPEMD-160 state as a digest, each field low-order byte first, the
+ * same order printHash() prints
+ * @param state the final state
+ * @param out room for the 20-byte digest
+*/
+static void digestBytes( HashState const *state, byte out[ HASH160_BYTES ] )
+{
+  longword fields[] = { state->A, state->B, state->C, state->D, state->E };
+  for( int i = 0; i < HASH160_BYTES / LW_BYTES; i++ ){
+    for( int j = 0; j < LW_BYTES; j++ ){
+      out[ i * LW_BYTES + j ] = fields[ i ] >> ( j * BBITS );
+    }
+  }
+}
+
+/**
+ * This function finishes HASH160, hashing a SHA-256 digest with RIPEMD-160 in a single block
+ * @param sha the SHA-256 digest
+ * @param out room for the 20-byte digest
+*/
+static void ripe32( byte const sha[ SHA_DIGEST_BYTES ], byte out[ HASH160_BYTES ] )
+{
+  byte block[ BLOCK_BYTES ];
+  memcpy( block, ripePadded, BLOCK_BYTES );
+  memcpy( block, sha, SHA_DIGEST_BYTES );
+
+  HashState state;
+  initState( &state );
+  hashBlock( &state, block );
+  digestBytes( &state, out );
+}
+
+/**
+ * This function computes HASH160 of a message, RIPEMD-160 of its SHA-256 digest
+ * @param data the message
+ * @param len the number of bytes in the message
+ * @param out room for the 20-byte digest
+*/
+void hash160( byte const *data, size_t len, byte out[ HASH160_BYTES ] )
+{
+  ShaCtx ctx;
+  shaInit( &ctx );
+  shaUpdate( &ctx, data, len );
+
+  byte sha[ SHA_DIGEST_BYTES ];
+  shaFinal( &ctx, sha );
+  ripe32( sha, out );
+}
+
+/** A batch of records that are all the same size */
+typedef struct {
+  /** Number of bytes in each record */
+  size_t recordLen;
+
+  /** For records that fit in one SHA-256 block, the padded block, with room for the record */
+  byte shaPadded[ BLOCK_BYTES ];
+
+  /** SHA-256 digests of the records waiting for their RIPEMD-160 half */
+  byte sha[ HASH160_BATCH ][ SHA_DIGEST_BYTES ];
+
+  /** One multi-buffer job for each waiting SHA-256 digest */
+  RipeJob jobs[ HASH160_BATCH ];
+
+  /** Finished digests, ready to be written */
+  byte out[ HASH160_BATCH * HASH160_BYTES ];
+
+  /** Number of records waiting */
+  int pending;
+} Batch;
+
+/**
+ * This function gets a batch ready for records of the given size, building the SHA-256 padding up
+ * front if a record fits in one block
+ * @param b the batch
+ * @param recordLen the number of bytes in each record
+*/
+static void startBatch( Batch *b, size_t recordLen )
+{
+  b->recordLen = recordLen;
+  b->pending = 0;
+  for( int r = 0; r < HASH160_BATCH; r++ ){
+    b->jobs[ r ].data = b->sha[ r ];
+    b->jobs[ r ].len = SHA_DIGEST_BYTES;
+  }
+
+  if( recordLen <= SHA_ONE_BLOCK_MAX ){
+    unsigned long long bits = ( unsigned long long )recordLen * BBITS;
+    memset( b->shaPadded, 0x00, BLOCK_BYTES );
+    b->shaPadded[ recordLen ] = 0x80;
+    for( int i = 0; i < BBITS; i++ ){
+      b->shaPadded[ BLOCK_BYTES - 1 - i ] = bits >> ( i * BBITS );
+    }
+  }
+}
+
+/**
+ * This function finishes the records waiting in a batch, hashing all of their SHA-256 digests with the
+ * multi-buffer engine, then writes out their HASH160 digests
+ * @param b the batch
+ * @return true if they were written
+*/
+static bool flushBatch( Batch *b )
+{
+  size_t n = b->pending;
+  b->pending = 0;
+
+  ripeMany( b->jobs, n );
+  for( size_t r = 0; r < n; r++ ){
+    digestBytes( &b->jobs[ r ].digest, b->out + r * HASH160_BYTES );
+  }
+
+  return fwrite( b->out, HASH160_BYTES, n, stdout ) == n;
+}
+
+/**
+ * This function hashes a run of whole records, writing out digests whenever the batch fills up
+ * @param b the batch
+ * @param data the first record
+ * @param count the number of records
+ * @return true if every digest that had to be written was written
+*/
+static bool hashRecords( Batch *b, byte const *data, size_t count )
+{
+  for( size_t r = 0; r < count; r++, data += b->recordLen ){
+    byte *sha = b->sha[ b->pending ];
+
+    if( b->recordLen <= SHA_ONE_BLOCK_MAX ){
+      // just the record changes from one to the next; the padding is already there
+      longword state[ SHA_STATE_WORDS ];
+      shaInitState( state );
+      memcpy( b->shaPadded, data, b->recordLen );
+      shaBlocks( state, b->shaPadded, 1 );
+      shaDigest( state, sha );
+    } else {
+      ShaCtx ctx;
+      shaInit( &ctx );
+      shaUpdate( &ctx, data, b->recordLen );
+      shaFinal( &ctx, sha );
+    }
+
+    if( ++b->pending == HASH160_BATCH && !flushBatch( b ) ){
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * This function hashes every record in a memory-mapped file
+ * @param b the batch
+ * @param path name of the file
+ * @return true if the whole file was hashed, or false after reporting an error
+*/
+static bool hashMappedRecords( Batch *b, char const *path )
+{
+  int fd = open( path, O_RDONLY );
+  struct stat st;
+  if( fd < 0 || fstat( fd, &st ) != 0 ){
+    perror( path );
+    if( fd >= 0 ){
+      close( fd );
+    }
+    return false;
+  }
+
+  if( st.st_size % b->recordLen != 0 ){
+    fprintf( stderr, "%s: size isn't a multiple of %zu bytes\n", path, b->recordLen );
+    close( fd );
+    return false;
+  }
+
+  bool ok = true;
+  if( st.st_size > 0 ){
+    byte *map = ( byte * )mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    if( map == MAP_FAILED ){
+      perror( path );
+      close( fd );
+      return false;
+    }
+
+    posix_madvise( map, st.st_size, POSIX_MADV_SEQUENTIAL );
+    ok = hashRecords( b, map, st.st_size / b->recordLen );
+    munmap( map, st.st_size );
+  }
+
+  close( fd );
+  return ok;
+}
+
+/**
+ * This function hashes every record from standard input, reading a batch of records at a time
+ * @param b the batch
+ * @return true if all of the input was hashed, or false after reporting an error
+*/
+static bool hashStdinRecords( Batch *b )
+{
+  size_t size = HASH160_BATCH * b->recordLen;
+  byte *buf = ( byte * )malloc( size );
+  bool ok = true;
+
+  size_t len;
+  while( ok && ( len = fread( buf, 1, size, stdin ) ) > 0 ){
+    if( len % b->recordLen != 0 ){
+      fprintf( stderr, "stdin: input isn't a multiple of %zu bytes\n", b->recordLen );
+      ok = false;
+    }
+    ok = hashRecords( b, buf, len / b->recordLen ) && ok;
+  }
+
+  if( ferror( stdin ) ){
+    perror( "stdin" );
+    ok = false;
+  }
+
+  free( buf );
+  return ok;
+}
+
+/**
+ * This function computes HASH160 of every record in a file, or standard input if the path is NULL,
+ * and writes the 20-byte digests to standard output in the same order, with nothing in between
+ * @param path name of the file, or NULL for standard input
+ * @param recordLen the number of bytes in each record
+ * @return program exit status
+*/
+int hash160Batch( char const *path, size_t recordLen )
+{
+  Batch *b = ( Batch * )malloc( sizeof( Batch ) );
+  startBatch( b, recordLen );
+
+  bool ok = path ? hashMappedRecords( b, path ) : hashStdinRecords( b );
+  if( !flushBatch( b ) || fflush( stdout ) != 0 ){
+    perror( "stdout" );
+    ok = false;
+  }
+
+  free( b );
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
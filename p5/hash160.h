@@ -0,0 +1,29 @@
+/**
+ * @file hash160.h
+ * @author Jake Donovan (jmpatte8)
+ * This header file is for HASH160, RIPEMD-160 of the SHA-256 of a message, the way Bitcoin hashes
+ * public keys.  Besides hashing one message, it can hash a whole file of fixed-size records, writing
+ * the 20-byte digests one after another.
+*/
+
+#ifndef _HASH160_H_
+/** Our HASH160 header */
+#define _HASH160_H_
+
+#include "sha256.h"
+
+/** Number of bytes in a HASH160 digest */
+#define HASH160_BYTES 20
+
+/** Largest record hash160Batch() accepts */
+#define HASH160_MAX_RECORD ( 1024 * 1024 )
+
+/** Number of records hashed between writes to standard output */
+#define HASH160_BATCH 4096
+
+/** hash160 function prototype */
+void hash160( byte const *data, size_t len, byte out[ HASH160_BYTES ] );
+/** hash160Batch function prototype */
+int hash160Batch( char const *path, size_t recordLen );
+
+#endif
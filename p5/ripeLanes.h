@@ -0,0 +1,79 @@
+/**
+ * @file ripeLanes.h
+ * @author Jake Donovan (jmpatte8)
+ * Template for a multi-buffer compression function, which hashes one block for each lane of a SIMD
+ * register at once.  ripeMulti.c includes this once for each instruction set, after defining:
+ *   LANE_FUNC          name of the function to define
+ *   LANE_TARGET        attributes for the function, like the instruction set it needs
+ *   VEC                the vector type
+ *   V_SET1( k )        a vector with k in every lane
+ *   V_ADD, V_XOR, V_OR, V_AND( a, b )   lane-wise operations
+ *   V_ANDNOT( a, b )   ~a & b in every lane
+ *   V_SLL, V_SRL( x, s )   shifts of every lane by a constant
+ *   V_LOAD( p ), V_STORE( p, x )   unaligned loads and stores of a row of the lane state
+ *   V_WORDS( block, i )    a vector of longword i from each lane's block
+*/
+
+/** Complement every bit */
+#define V_NOT( x ) V_XOR( x, V_SET1( -1 ) )
+
+/** Rotate every lane left by a constant number of bits */
+#define V_ROTL( x, s ) V_OR( V_SLL( x, s ), V_SRL( x, LW_BITS - ( s ) ) )
+
+/** Bitwise function 0, for every lane */
+#define F0( b, c, d ) V_XOR( V_XOR( b, c ), d )
+
+/** Bitwise function 1 */
+#define F1( b, c, d ) V_OR( V_AND( b, c ), V_ANDNOT( b, d ) )
+
+/** Bitwise function 2 */
+#define F2( b, c, d ) V_XOR( V_OR( b, V_NOT( c ) ), d )
+
+/** Bitwise function 3 */
+#define F3( b, c, d ) V_OR( V_AND( b, d ), V_ANDNOT( d, c ) )
+
+/** Bitwise function 4 */
+#define F4( b, c, d ) V_XOR( b, V_OR( c, V_NOT( d ) ) )
+
+/** One iteration for every lane, the same as the STEP in ripeMD.c */
+#define STEP( f, a, b, c, d, e, x, s, k ) { \
+    a = V_ADD( a, V_ADD( V_ADD( f( b, c, d ), x ), V_SET1( ( int )( k ) ) ) ); \
+    a = V_ADD( V_ROTL( a, s ), e ); \
+    c = V_ROTL( c, C_ROTATION ); \
+  }
+
+/**
+ * This function processes one block for each lane, updating the lane states
+ * @param st the state of every lane, with one row for each field
+ * @param block the next block for each lane
+*/
+static LANE_TARGET void LANE_FUNC( LaneState st, byte const *block[ MAX_LANES ] )
+{
+  VEC w[ BLOCK_LONGWORDS ];
+  for( int i = 0; i < BLOCK_LONGWORDS; i++ ) {
+    w[ i ] = V_WORDS( block, i );
+  }
+
+  VEC al = V_LOAD( st[ 0 ] ), bl = V_LOAD( st[ 1 ] ), cl = V_LOAD( st[ 2 ] );
+  VEC dl = V_LOAD( st[ 3 ] ), el = V_LOAD( st[ 4 ] );
+  VEC ar = al, br = bl, cr = cl, dr = dl, er = el;
+
+#include "ripeSteps.h"
+
+  // combine the two sides with the input state, the same as hashBlock()
+  VEC t = V_ADD( V_ADD( V_LOAD( st[ 1 ] ), cl ), dr );
+  V_STORE( st[ 1 ], V_ADD( V_ADD( V_LOAD( st[ 2 ] ), dl ), er ) );
+  V_STORE( st[ 2 ], V_ADD( V_ADD( V_LOAD( st[ 3 ] ), el ), ar ) );
+  V_STORE( st[ 3 ], V_ADD( V_ADD( V_LOAD( st[ 4 ] ), al ), br ) );
+  V_STORE( st[ 4 ], V_ADD( V_ADD( V_LOAD( st[ 0 ] ), bl ), cr ) );
+  V_STORE( st[ 0 ], t );
+}
+
+#undef V_NOT
+#undef V_ROTL
+#undef F0
+#undef F1
+#undef F2
+#undef F3
+#undef F4
+#undef STEP
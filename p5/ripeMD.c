@@ -10,6 +10,7 @@
 #include "byteBuffer.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 /**
  * Given the address of a HashState instance, this funciton intializes its fields, filling them in
@@ -32,42 +33,23 @@ void initState( HashState *state )
 */
 void padBuffer( ByteBuffer *buffer )
 {
-   // save our original total
-  int original = buffer->len;
+  // save our original total
+  size_t original = buffer->len;
 
-  // add Ox80 byte
-  addByte(buffer, 0x80);
+  // the 0x80 byte and the eight length bytes, with zeros in between to reach a multiple of 64
+  size_t zeros = ( BLOCK_BYTES - ( original + 1 + BBITS ) % BLOCK_BYTES ) % BLOCK_BYTES;
+  reserve( buffer, 1 + zeros + BBITS );
 
-  // calculate the total length we need to get a multiple of 64
-  int total = buffer->len;
+  addByte( buffer, 0x80 );
+  appendFill( buffer, 0x00, zeros );
 
-  // increment total until we have a multiple of 64
-  while( (total % BLOCK_BYTES ) != 0 ){
-    total++;
-  }
-
-  // set total to be 8 less than our target value because we need to leave eight bytes at the end
-  total = total - BBITS;
-
-  while( buffer->len < total ){
-    addByte( buffer, 0x00 );
-  }
-
-  // calculate our value to add at the end
-  // this is an unsigned char
-  unsigned long x = original * BBITS;
-
-  byte mask = 0xFF;
-
-  for(int i = 0; i < BLOCK_BYTES; i += BBITS) {
-    if( i > 0 ) {
-      addByte( buffer, ( ( x >> i ) & mask ) );
-    }
-    
-    else {
-      addByte( buffer, ( x & mask ) );
-    }
+  // the length in bits goes at the end, low-order byte first
+  unsigned long long x = ( unsigned long long )original * BBITS;
+  byte len[ BBITS ];
+  for( int i = 0; i < BBITS; i++ ){
+    len[ i ] = x >> ( i * BBITS );
   }
+  appendBytes( buffer, len, BBITS );
 }
 
 /**
@@ -127,6 +109,35 @@ void printHash( HashState *state )
   fprintf(stdout, "%08x%08x%08x%08x%08x\n", state->A, state->B, state->C, state->D, state->E );
 }
 
+/**
+ * This function writes the final hash value stored in the given state as a string of hex digits, the
+ * same way printHash() prints it, without changing the state
+ * @param state the final state
+ * @param str room for the digits and a null terminator
+*/
+void hashString( HashState const *state, char str[ HASH_CHARS + 1 ] )
+{
+  longword fields[] = { state->A, state->B, state->C, state->D, state->E };
+  char const *digits = "0123456789abcdef";
+
+  // each field is printed low-order byte first
+  int len = 0;
+  for( int i = 0; i < sizeof( fields ) / sizeof( fields[ 0 ] ); i++ ){
+    for( int j = 0; j < LW_BYTES; j++ ){
+      byte b = fields[ i ] >> ( j * BBITS );
+      str[ len++ ] = digits[ b >> 4 ];
+      str[ len++ ] = digits[ b & 0xF ];
+    }
+  }
+
+  str[ len ] = '\0';
+}
+
+// The table-driven compression function below is the straightforward
+// version of the algorithm.  It's only built for unit tests, or when
+// TABLE_HASH is defined to use it instead of the unrolled one.
+#if defined( TABLE_HASH ) || defined( TESTABLE )
+
 /**
  * Version 0 of bitwise function f for combining longwords a, b, and c
  * @param a the first longword
@@ -273,7 +284,7 @@ static void hashRound( HashState *state, longword data[ BLOCK_LONGWORDS ], int p
  * @param state the input state
  * @param block the passed block of 64-bytes
 */
-void hashBlock( HashState *state, byte block[ BLOCK_BYTES ] )
+static void hashBlockTable( HashState *state, byte block[ BLOCK_BYTES ] )
 {
   // we know that our buffer has a number of elements that is a multiple of 64
   // so we can use memcpy to pick each 64 byte array in our buffer until we hit len
@@ -386,6 +397,207 @@ void hashBlock( HashState *state, byte block[ BLOCK_BYTES ] )
   state->E = startingState.A + leftRoundsState.B + rightRoundsState.C;
 }
 
+#endif
+
+#ifdef TABLE_HASH
+
+/**
+ * This function processes a run of whole blocks with the table-driven compression function
+ * @param state the input state, replaced with the output state
+ * @param data the first block
+ * @param nblocks the number of blocks
+*/
+void hashBlocks( HashState *state, byte const *data, size_t nblocks )
+{
+  for( size_t i = 0; i < nblocks; i++ ){
+    hashBlockTable( state, ( byte * )data + i * BLOCK_BYTES );
+  }
+}
+
+#else
+
+/** Bitwise function 0, as a macro so the unrolled steps don't make calls */
+#define F0( b, c, d ) ( ( b ) ^ ( c ) ^ ( d ) )
+
+/** Bitwise function 1 */
+#define F1( b, c, d ) ( ( ( b ) & ( c ) ) | ( ~( b ) & ( d ) ) )
+
+/** Bitwise function 2 */
+#define F2( b, c, d ) ( ( ( b ) | ~( c ) ) ^ ( d ) )
+
+/** Bitwise function 3 */
+#define F3( b, c, d ) ( ( ( b ) & ( d ) ) | ( ( c ) & ~( d ) ) )
+
+/** Bitwise function 4 */
+#define F4( b, c, d ) ( ( b ) ^ ( ( c ) | ~( d ) ) )
+
+/** Rotate a longword left by a constant number of bits */
+#define ROTL( x, s ) ( ( ( x ) << ( s ) ) | ( ( x ) >> ( LW_BITS - ( s ) ) ) )
+
+/** One iteration, the same as hashIteration() but with everything known at compile time.  Instead
+    of moving every field of the state over by one, the caller names the fields in their new order
+    for the next step */
+#define STEP( f, a, b, c, d, e, x, s, k ) { \
+    a += f( b, c, d ) + ( x ) + ( k ); \
+    a = ROTL( a, s ) + e; \
+    c = ROTL( c, C_ROTATION ); \
+  }
+
+/**
+ * This function processes a run of whole blocks, giving the same result as the table-driven version
+ * one block at a time. All 160 iterations are written out, with the data index, shift, noise and
+ * bitwise function for each one fixed at compile time. The left and right sides don't depend on each
+ * other until the very end, so their iterations are interleaved to let the CPU work on both at once.
+ * Each data word is loaded straight from the caller's buffer, which doesn't have to be aligned, and
+ * the state stays in local variables from one block to the next
+ * @param state the input state, replaced with the output state
+ * @param data the first block
+ * @param nblocks the number of blocks
+*/
+void hashBlocks( HashState *state, byte const *data, size_t nblocks )
+{
+  longword a = state->A, b = state->B, c = state->C, d = state->D, e = state->E;
+
+  for( ; nblocks > 0; nblocks--, data += BLOCK_BYTES ){
+    longword w[ BLOCK_LONGWORDS ];
+    for( int i = 0; i < BLOCK_LONGWORDS; i++ ) {
+      w[ i ] = loadWord( data + LW_BYTES * i );
+    }
+
+    longword al = a, bl = b, cl = c, dl = d, el = e;
+    longword ar = a, br = b, cr = c, dr = d, er = e;
+
+#include "ripeSteps.h"
+
+    // combine the two sides with the input state; after 80 steps each, the fields are back in order
+    longword t = b + cl + dr;
+    b = c + dl + er;
+    c = d + el + ar;
+    d = e + al + br;
+    e = a + bl + cr;
+    a = t;
+  }
+
+  state->A = a;
+  state->B = b;
+  state->C = c;
+  state->D = d;
+  state->E = e;
+}
+
+#endif
+
+/**
+ * This function processes the given block of 64-bytes
+ * @param state the input state, replaced with the output state
+ * @param block the passed block of 64-bytes
+*/
+void hashBlock( HashState *state, byte const block[ BLOCK_BYTES ] )
+{
+  hashBlocks( state, block, 1 );
+}
+
+/**
+ * This function gets a streaming context ready to hash a new input, starting with the initial state
+ * and an empty block
+ * @param ctx the context to initialize
+*/
+void ripeInit( RipeCtx *ctx )
+{
+  initState( &ctx->state );
+  ctx->blockLen = 0;
+  ctx->total = 0;
+}
+
+/**
+ * This function adds more input to a streaming hash. Every block that's completed gets hashed right
+ * away, and whole blocks are hashed straight out of the caller's data without being copied. Whatever
+ * is left over is saved in the context for the next call
+ * @param ctx the streaming context
+ * @param data the next bytes of input
+ * @param len the number of bytes in data
+*/
+void ripeUpdate( RipeCtx *ctx, byte const *data, size_t len )
+{
+  ctx->total += len;
+
+  // finish off a block left over from last time
+  if( ctx->blockLen > 0 ){
+    size_t n = BLOCK_BYTES - ctx->blockLen;
+    if( n > len ){
+      n = len;
+    }
+
+    memcpy( ctx->block + ctx->blockLen, data, n );
+    ctx->blockLen += n;
+    data += n;
+    len -= n;
+
+    if( ctx->blockLen < BLOCK_BYTES ){
+      return;
+    }
+
+    hashBlock( &ctx->state, ctx->block );
+    ctx->blockLen = 0;
+  }
+
+  // hash whole blocks in place, all in one call
+  size_t whole = len / BLOCK_BYTES;
+  hashBlocks( &ctx->state, data, whole );
+  data += whole * BLOCK_BYTES;
+  len -= whole * BLOCK_BYTES;
+
+  // save the rest for later
+  memcpy( ctx->block, data, len );
+  ctx->blockLen = len;
+}
+
+/**
+ * This function builds the last block or two of a message. It copies the bytes left over after the
+ * message's last whole block and pads them the same way padBuffer() does, with a 0x80 byte, zeros,
+ * and the length of the whole message in bits
+ * @param tail room for the padded blocks
+ * @param rest the bytes after the last whole block
+ * @param restLen the number of bytes in rest, less than BLOCK_BYTES
+ * @param total the length of the whole message, in bytes
+ * @return the number of blocks in tail, 1 or 2
+*/
+int padTail( byte tail[ 2 * BLOCK_BYTES ], byte const *rest, size_t restLen, unsigned long long total )
+{
+  unsigned long long bits = total * BBITS;
+
+  // if there's no room left for the length, it goes in a block of its own
+  int blocks = restLen + 1 > BLOCK_BYTES - BBITS ? 2 : 1;
+  int end = blocks * BLOCK_BYTES;
+
+  memcpy( tail, rest, restLen );
+  tail[ restLen ] = 0x80;
+  memset( tail + restLen + 1, 0x00, end - BBITS - restLen - 1 );
+
+  // the length goes at the end, low-order byte first
+  for( int i = 0; i < BBITS; i++ ){
+    tail[ end - BBITS + i ] = ( bits >> ( i * BBITS ) ) & 0xFF;
+  }
+
+  return blocks;
+}
+
+/**
+ * This function finishes a streaming hash. It pads the last block with padTail(), hashes what's left
+ * and gives back the final state
+ * @param ctx the streaming context, which has to be initialized again before it's reused
+ * @param state the final hash state, ready for printHash()
+*/
+void ripeFinal( RipeCtx *ctx, HashState *state )
+{
+  byte tail[ 2 * BLOCK_BYTES ];
+  int blocks = padTail( tail, ctx->block, ctx->blockLen, ctx->total );
+
+  hashBlocks( &ctx->state, tail, blocks );
+
+  *state = ctx->state;
+}
+
 // Put the following at the end of your implementation file.
 // If we're compiling for unit tests, create wrappers for the otherwise
 // private functions we'd like to be able to test.
@@ -441,4 +653,9 @@ void hashRoundWrapper( HashState *state,
   hashRound( state, block, perm, shift, noise, f );
 }
 
+void hashBlockTableWrapper( HashState *state, byte block[ BLOCK_BYTES ] )
+{
+  hashBlockTable( state, block );
+}
+
 #endif
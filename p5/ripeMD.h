@@ -11,6 +11,8 @@
 #define _RIPEMD_H_
 
 #include "byteBuffer.h"
+#include <stddef.h>
+#include <string.h>
 
 /** Name for an unsigned 32-bit integer. */
 typedef unsigned int longword;
@@ -45,6 +47,25 @@ typedef unsigned int longword;
 /** Number of bytes we are adding to each longword */
 #define LW_BYTES 4
 
+/** Number of hex digits in a printed hash */
+#define HASH_CHARS 40
+
+/**
+ * This function loads a little-endian longword from any address, aligned or not.  The memcpy()
+ * becomes a single load on machines that allow unaligned ones
+ * @param p where the longword starts
+ * @return the longword
+*/
+static inline longword loadWord( byte const *p )
+{
+  longword w;
+  memcpy( &w, p, sizeof( w ) );
+#if defined( __BYTE_ORDER__ ) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  w = __builtin_bswap32( w );
+#endif
+  return w;
+}
+
 /** Type for a pointer to the bitwise f function used in each round. */
 typedef longword (*BitwiseFunction)( longword b, longword c, longword d );
 
@@ -70,14 +91,44 @@ typedef struct {
   
 } HashState;
 
+/** Streaming hash computation.  Input can be given in pieces of any
+    size with ripeUpdate(); bytes that don't fill a whole block yet are
+    held in the context until more input arrives.  Padding is only added
+    by ripeFinal(), so the input never has to be in memory all at once. */
+typedef struct {
+  /** State of the hash after every complete block so far. */
+  HashState state;
+
+  /** Bytes of the current, partly filled block. */
+  byte block[ BLOCK_BYTES ];
+
+  /** Number of bytes in the current block. */
+  unsigned int blockLen;
+
+  /** Total number of bytes of input so far. */
+  unsigned long long total;
+} RipeCtx;
+
 /** initState function prototype */
 void initState( HashState * state );
 /** padBuffer function prototype */
 void padBuffer( ByteBuffer *buffer );
+/** hashString function prototype */
+void hashString( HashState const *state, char str[ HASH_CHARS + 1 ] );
 /** printHash function prototype */
 void printHash( HashState *state );
 /** hashBlock function prototype */
-void hashBlock( HashState *state, byte block[ BLOCK_BYTES ] );
+void hashBlock( HashState *state, byte const block[ BLOCK_BYTES ] );
+/** hashBlocks function prototype */
+void hashBlocks( HashState *state, byte const *data, size_t nblocks );
+/** ripeInit function prototype */
+void ripeInit( RipeCtx *ctx );
+/** ripeUpdate function prototype */
+void ripeUpdate( RipeCtx *ctx, byte const *data, size_t len );
+/** padTail function prototype */
+int padTail( byte tail[ 2 * BLOCK_BYTES ], byte const *rest, size_t restLen, unsigned long long total );
+/** ripeFinal function prototype */
+void ripeFinal( RipeCtx *ctx, HashState *state );
 
 
 
@@ -111,6 +162,8 @@ void hashRoundWrapper( HashState *state,
                        longword noise,
                        BitwiseFunction f );
 
+void hashBlockTableWrapper( HashState *state, byte block[ BLOCK_BYTES ] );
+
 #endif
 
 #endif
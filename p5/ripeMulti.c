@@ -0,0 +1,324 @@
+/**
+ * @file ripeMulti.c
+ * @author Jake Donovan (jmpatte8)
+ * This file is responsible for hashing many independent messages at once.  Each lane of the engine
+ * works on its own message, and a simple scheduler hands a lane the next message as soon as the one
+ * it was working on is done, so messages of different lengths keep every lane busy.
+*/
+
+#include "ripeMulti.h"
+#include <string.h>
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#include <immintrin.h>
+/** Defined if we can build the SIMD engines */
+#define X86_ENGINES
+#endif
+
+/** Number of fields in a hash state */
+#define STATE_FIELDS 5
+
+/** State of every lane, with one row for each field so a row loads straight into a vector */
+typedef longword LaneState[ STATE_FIELDS ][ MAX_LANES ];
+
+/** Type for a function that processes one block for each lane */
+typedef void (*LaneFunction)( LaneState st, byte const *block[ MAX_LANES ] );
+
+/** One way of hashing messages in parallel */
+typedef struct {
+  /** Name for the engine, used by ripeSetEngine() */
+  char const *name;
+
+  /** Number of messages it works on at once */
+  int lanes;
+
+  /** Function that processes a block for each lane */
+  LaneFunction compress;
+} Engine;
+
+/** A lane and the message it's working on */
+typedef struct {
+  /** The message, or NULL if the lane is idle */
+  RipeJob *job;
+
+  /** Number of blocks of the message, including padding */
+  size_t blocks;
+
+  /** Number of blocks handed out so far */
+  size_t done;
+
+  /** The padded end of the message */
+  byte tail[ 2 * BLOCK_BYTES ];
+} Lane;
+
+/**
+ * This function processes a block for the only lane of the scalar engine, with hashBlock()
+ * @param st the lane state
+ * @param block the next block
+*/
+static void compressScalar( LaneState st, byte const *block[ MAX_LANES ] )
+{
+  HashState state = { st[ 0 ][ 0 ], st[ 1 ][ 0 ], st[ 2 ][ 0 ], st[ 3 ][ 0 ], st[ 4 ][ 0 ] };
+  hashBlock( &state, block[ 0 ] );
+  st[ 0 ][ 0 ] = state.A;
+  st[ 1 ][ 0 ] = state.B;
+  st[ 2 ][ 0 ] = state.C;
+  st[ 3 ][ 0 ] = state.D;
+  st[ 4 ][ 0 ] = state.E;
+}
+
+#ifdef X86_ENGINES
+
+// Four lanes with SSE2, which every x86-64 processor has.
+#define LANE_FUNC compressSSE2
+#define LANE_TARGET __attribute__(( target( "sse2" ) ))
+#define VEC __m128i
+#define V_SET1( k ) _mm_set1_epi32( k )
+#define V_ADD( a, b ) _mm_add_epi32( a, b )
+#define V_XOR( a, b ) _mm_xor_si128( a, b )
+#define V_OR( a, b ) _mm_or_si128( a, b )
+#define V_AND( a, b ) _mm_and_si128( a, b )
+#define V_ANDNOT( a, b ) _mm_andnot_si128( a, b )
+#define V_SLL( x, s ) _mm_slli_epi32( x, s )
+#define V_SRL( x, s ) _mm_srli_epi32( x, s )
+#define V_LOAD( p ) _mm_loadu_si128( ( __m128i const * )( p ) )
+#define V_STORE( p, x ) _mm_storeu_si128( ( __m128i * )( p ), x )
+#define V_WORDS( block, i ) \
+  _mm_set_epi32( loadWord( block[ 3 ] + LW_BYTES * ( i ) ), loadWord( block[ 2 ] + LW_BYTES * ( i ) ), \
+                 loadWord( block[ 1 ] + LW_BYTES * ( i ) ), loadWord( block[ 0 ] + LW_BYTES * ( i ) ) )
+
+#include "ripeLanes.h"
+
+#undef LANE_FUNC
+#undef LANE_TARGET
+#undef VEC
+#undef V_SET1
+#undef V_ADD
+#undef V_XOR
+#undef V_OR
+#undef V_AND
+#undef V_ANDNOT
+#undef V_SLL
+#undef V_SRL
+#undef V_LOAD
+#undef V_STORE
+#undef V_WORDS
+
+// Eight lanes with AVX2, only used if the processor has it.
+#define LANE_FUNC compressAVX2
+#define LANE_TARGET __attribute__(( target( "avx2" ) ))
+#define VEC __m256i
+#define V_SET1( k ) _mm256_set1_epi32( k )
+#define V_ADD( a, b ) _mm256_add_epi32( a, b )
+#define V_XOR( a, b ) _mm256_xor_si256( a, b )
+#define V_OR( a, b ) _mm256_or_si256( a, b )
+#define V_AND( a, b ) _mm256_and_si256( a, b )
+#define V_ANDNOT( a, b ) _mm256_andnot_si256( a, b )
+#define V_SLL( x, s ) _mm256_slli_epi32( x, s )
+#define V_SRL( x, s ) _mm256_srli_epi32( x, s )
+#define V_LOAD( p ) _mm256_loadu_si256( ( __m256i const * )( p ) )
+#define V_STORE( p, x ) _mm256_storeu_si256( ( __m256i * )( p ), x )
+#define V_WORDS( block, i ) \
+  _mm256_set_epi32( loadWord( block[ 7 ] + LW_BYTES * ( i ) ), loadWord( block[ 6 ] + LW_BYTES * ( i ) ), \
+                    loadWord( block[ 5 ] + LW_BYTES * ( i ) ), loadWord( block[ 4 ] + LW_BYTES * ( i ) ), \
+                    loadWord( block[ 3 ] + LW_BYTES * ( i ) ), loadWord( block[ 2 ] + LW_BYTES * ( i ) ), \
+                    loadWord( block[ 1 ] + LW_BYTES * ( i ) ), loadWord( block[ 0 ] + LW_BYTES * ( i ) ) )
+
+#include "ripeLanes.h"
+
+#undef LANE_FUNC
+#undef LANE_TARGET
+#undef VEC
+#undef V_SET1
+#undef V_ADD
+#undef V_XOR
+#undef V_OR
+#undef V_AND
+#undef V_ANDNOT
+#undef V_SLL
+#undef V_SRL
+#undef V_LOAD
+#undef V_STORE
+#undef V_WORDS
+
+#endif
+
+/** Every engine, widest first */
+static Engine const engines[] = {
+#ifdef X86_ENGINES
+  { "avx2", 8, compressAVX2 },
+  { "sse2", 4, compressSSE2 },
+#endif
+  { "scalar", 1, compressScalar },
+};
+
+/** Number of engines */
+#define ENGINE_COUNT ( sizeof( engines ) / sizeof( engines[ 0 ] ) )
+
+/** Engine ripeMany() uses, or NULL until one has been chosen */
+static Engine const *engine = NULL;
+
+/**
+ * This function reports whether the processor can run the given engine
+ * @param e the engine to check
+ * @return true if it can be used
+*/
+static bool supported( Engine const *e )
+{
+#ifdef X86_ENGINES
+  if( strcmp( e->name, "avx2" ) == 0 ){
+    return __builtin_cpu_supports( "avx2" );
+  }
+#endif
+  return true;
+}
+
+/**
+ * This function picks the engine to use, the first in the list the processor supports, unless
+ * ripeSetEngine() already picked one
+ * @return the engine
+*/
+static Engine const *chooseEngine()
+{
+  if( engine == NULL ){
+    int i = 0;
+    while( !supported( engines + i ) ){
+      i++;
+    }
+    engine = engines + i;
+  }
+
+  return engine;
+}
+
+/**
+ * This function picks the engine ripeMany() uses by name, "avx2", "sse2" or "scalar", or goes back
+ * to picking the best one if the name is NULL
+ * @param name the engine to use
+ * @return true if the engine exists and this processor can run it
+*/
+bool ripeSetEngine( char const *name )
+{
+  if( name == NULL ){
+    engine = NULL;
+    return true;
+  }
+
+  for( int i = 0; i < ENGINE_COUNT; i++ ){
+    if( strcmp( engines[ i ].name, name ) == 0 && supported( engines + i ) ){
+      engine = engines + i;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/**
+ * This function gives the name of the engine ripeMany() uses
+ * @return the engine's name
+*/
+char const *ripeEngineName()
+{
+  return chooseEngine()->name;
+}
+
+/**
+ * This function gives an idle lane the next message, if there are any left, and resets its state
+ * @param lane the lane
+ * @param st the lane states
+ * @param l the lane's index
+ * @param jobs the messages
+ * @param count the number of messages
+ * @param next index of the next message to hand out, updated
+ * @return true if the lane got a message
+*/
+static bool startLane( Lane *lane, LaneState st, int l, RipeJob *jobs, size_t count, size_t *next )
+{
+  if( *next >= count ){
+    lane->job = NULL;
+    return false;
+  }
+
+  RipeJob *job = jobs + ( *next )++;
+  lane->job = job;
+  lane->done = 0;
+
+  // whole blocks come straight from the message, and the rest from the padded tail
+  size_t whole = job->len / BLOCK_BYTES;
+  lane->blocks = whole + padTail( lane->tail, job->data + whole * BLOCK_BYTES,
+                                  job->len % BLOCK_BYTES, job->len );
+
+  HashState state;
+  initState( &state );
+  st[ 0 ][ l ] = state.A;
+  st[ 1 ][ l ] = state.B;
+  st[ 2 ][ l ] = state.C;
+  st[ 3 ][ l ] = state.D;
+  st[ 4 ][ l ] = state.E;
+  return true;
+}
+
+/**
+ * This function gives the next block of a lane's message
+ * @param lane the lane, which has to be working on a message
+ * @return the block
+*/
+static byte const *nextBlock( Lane *lane )
+{
+  size_t whole = lane->job->len / BLOCK_BYTES;
+  size_t n = lane->done++;
+  if( n < whole ){
+    return lane->job->data + n * BLOCK_BYTES;
+  }
+
+  return lane->tail + ( n - whole ) * BLOCK_BYTES;
+}
+
+/**
+ * This function hashes every message in the list, filling in their digests. Each lane of the engine
+ * takes the next message as soon as it finishes one, so lanes only sit idle once there aren't enough
+ * messages left to go around
+ * @param jobs the messages
+ * @param count the number of messages
+*/
+void ripeMany( RipeJob *jobs, size_t count )
+{
+  Engine const *e = chooseEngine();
+
+  // lanes beyond the engine's width, and idle ones, hash a block of zeros that's thrown away
+  static byte const idle[ BLOCK_BYTES ] = { 0 };
+  Lane lane[ MAX_LANES ];
+  LaneState st = { { 0 } };
+  byte const *block[ MAX_LANES ];
+  for( int l = 0; l < MAX_LANES; l++ ){
+    block[ l ] = idle;
+  }
+
+  size_t next = 0;
+  int active = 0;
+  for( int l = 0; l < e->lanes; l++ ){
+    if( startLane( lane + l, st, l, jobs, count, &next ) ){
+      active++;
+    }
+  }
+
+  while( active > 0 ){
+    for( int l = 0; l < e->lanes; l++ ){
+      block[ l ] = lane[ l ].job ? nextBlock( lane + l ) : idle;
+    }
+
+    e->compress( st, block );
+
+    // hand out new messages to lanes that just finished
+    for( int l = 0; l < e->lanes; l++ ){
+      RipeJob *job = lane[ l ].job;
+      if( job && lane[ l ].done == lane[ l ].blocks ){
+        job->digest = ( HashState ){ st[ 0 ][ l ], st[ 1 ][ l ], st[ 2 ][ l ], st[ 3 ][ l ], st[ 4 ][ l ] };
+        if( !startLane( lane + l, st, l, jobs, count, &next ) ){
+          active--;
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,39 @@
+/**
+ * @file ripeMulti.h
+ * @author Jake Donovan (jmpatte8)
+ * This header file is for the multi-buffer hashing engine, which hashes many independent messages
+ * at once, one in each lane of a SIMD register.  The widest engine the CPU supports is picked at
+ * run time: 8 lanes with AVX2, 4 lanes with SSE2, or one message at a time with plain hashBlock().
+*/
+
+#ifndef _RIPE_MULTI_H_
+/** Our multi-buffer header */
+#define _RIPE_MULTI_H_
+
+#include "ripeMD.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/** Most lanes any engine uses */
+#define MAX_LANES 8
+
+/** One message for ripeMany() to hash, and its result */
+typedef struct {
+  /** Bytes of the message, which don't have to be padded */
+  byte const *data;
+
+  /** Number of bytes in the message */
+  size_t len;
+
+  /** Final hash state for the message, filled in by ripeMany() */
+  HashState digest;
+} RipeJob;
+
+/** ripeMany function prototype */
+void ripeMany( RipeJob *jobs, size_t count );
+/** ripeSetEngine function prototype */
+bool ripeSetEngine( char const *name );
+/** ripeEngineName function prototype */
+char const *ripeEngineName();
+
+#endif
@@ -0,0 +1,178 @@
+/**
+ * @file ripeSteps.h
+ * @author Jake Donovan (jmpatte8)
+ * All 160 iterations of the RIPEMD compression function, written out with the data index, shift and
+ * noise for each one, and the left and right sides interleaved.  This is included in the middle of a
+ * compression function, which has to define F0 through F4 and STEP( f, a, b, c, d, e, x, s, k ) for
+ * the kind of values it works on, and have the data words in w and the state in al through el and
+ * ar through er.  After the last step, the fields are back in their starting order.
+*/
+  // round 0, left side uses F0 and right side uses F4
+  STEP( F0, al, bl, cl, dl, el, w[  0 ], 11, 0x00000000 );
+  STEP( F4, ar, br, cr, dr, er, w[  5 ],  8, 0x50A28BE6 );
+  STEP( F0, el, al, bl, cl, dl, w[  1 ], 14, 0x00000000 );
+  STEP( F4, er, ar, br, cr, dr, w[ 14 ],  9, 0x50A28BE6 );
+  STEP( F0, dl, el, al, bl, cl, w[  2 ], 15, 0x00000000 );
+  STEP( F4, dr, er, ar, br, cr, w[  7 ],  9, 0x50A28BE6 );
+  STEP( F0, cl, dl, el, al, bl, w[  3 ], 12, 0x00000000 );
+  STEP( F4, cr, dr, er, ar, br, w[  0 ], 11, 0x50A28BE6 );
+  STEP( F0, bl, cl, dl, el, al, w[  4 ],  5, 0x00000000 );
+  STEP( F4, br, cr, dr, er, ar, w[  9 ], 13, 0x50A28BE6 );
+  STEP( F0, al, bl, cl, dl, el, w[  5 ],  8, 0x00000000 );
+  STEP( F4, ar, br, cr, dr, er, w[  2 ], 15, 0x50A28BE6 );
+  STEP( F0, el, al, bl, cl, dl, w[  6 ],  7, 0x00000000 );
+  STEP( F4, er, ar, br, cr, dr, w[ 11 ], 15, 0x50A28BE6 );
+  STEP( F0, dl, el, al, bl, cl, w[  7 ],  9, 0x00000000 );
+  STEP( F4, dr, er, ar, br, cr, w[  4 ],  5, 0x50A28BE6 );
+  STEP( F0, cl, dl, el, al, bl, w[  8 ], 11, 0x00000000 );
+  STEP( F4, cr, dr, er, ar, br, w[ 13 ],  7, 0x50A28BE6 );
+  STEP( F0, bl, cl, dl, el, al, w[  9 ], 13, 0x00000000 );
+  STEP( F4, br, cr, dr, er, ar, w[  6 ],  7, 0x50A28BE6 );
+  STEP( F0, al, bl, cl, dl, el, w[ 10 ], 14, 0x00000000 );
+  STEP( F4, ar, br, cr, dr, er, w[ 15 ],  8, 0x50A28BE6 );
+  STEP( F0, el, al, bl, cl, dl, w[ 11 ], 15, 0x00000000 );
+  STEP( F4, er, ar, br, cr, dr, w[  8 ], 11, 0x50A28BE6 );
+  STEP( F0, dl, el, al, bl, cl, w[ 12 ],  6, 0x00000000 );
+  STEP( F4, dr, er, ar, br, cr, w[  1 ], 14, 0x50A28BE6 );
+  STEP( F0, cl, dl, el, al, bl, w[ 13 ],  7, 0x00000000 );
+  STEP( F4, cr, dr, er, ar, br, w[ 10 ], 14, 0x50A28BE6 );
+  STEP( F0, bl, cl, dl, el, al, w[ 14 ],  9, 0x00000000 );
+  STEP( F4, br, cr, dr, er, ar, w[  3 ], 12, 0x50A28BE6 );
+  STEP( F0, al, bl, cl, dl, el, w[ 15 ],  8, 0x00000000 );
+  STEP( F4, ar, br, cr, dr, er, w[ 12 ],  6, 0x50A28BE6 );
+
+  // round 1, left side uses F1 and right side uses F3
+  STEP( F1, el, al, bl, cl, dl, w[  7 ],  7, 0x5A827999 );
+  STEP( F3, er, ar, br, cr, dr, w[  6 ],  9, 0x5C4DD124 );
+  STEP( F1, dl, el, al, bl, cl, w[  4 ],  6, 0x5A827999 );
+  STEP( F3, dr, er, ar, br, cr, w[ 11 ], 13, 0x5C4DD124 );
+  STEP( F1, cl, dl, el, al, bl, w[ 13 ],  8, 0x5A827999 );
+  STEP( F3, cr, dr, er, ar, br, w[  3 ], 15, 0x5C4DD124 );
+  STEP( F1, bl, cl, dl, el, al, w[  1 ], 13, 0x5A827999 );
+  STEP( F3, br, cr, dr, er, ar, w[  7 ],  7, 0x5C4DD124 );
+  STEP( F1, al, bl, cl, dl, el, w[ 10 ], 11, 0x5A827999 );
+  STEP( F3, ar, br, cr, dr, er, w[  0 ], 12, 0x5C4DD124 );
+  STEP( F1, el, al, bl, cl, dl, w[  6 ],  9, 0x5A827999 );
+  STEP( F3, er, ar, br, cr, dr, w[ 13 ],  8, 0x5C4DD124 );
+  STEP( F1, dl, el, al, bl, cl, w[ 15 ],  7, 0x5A827999 );
+  STEP( F3, dr, er, ar, br, cr, w[  5 ],  9, 0x5C4DD124 );
+  STEP( F1, cl, dl, el, al, bl, w[  3 ], 15, 0x5A827999 );
+  STEP( F3, cr, dr, er, ar, br, w[ 10 ], 11, 0x5C4DD124 );
+  STEP( F1, bl, cl, dl, el, al, w[ 12 ],  7, 0x5A827999 );
+  STEP( F3, br, cr, dr, er, ar, w[ 14 ],  7, 0x5C4DD124 );
+  STEP( F1, al, bl, cl, dl, el, w[  0 ], 12, 0x5A827999 );
+  STEP( F3, ar, br, cr, dr, er, w[ 15 ],  7, 0x5C4DD124 );
+  STEP( F1, el, al, bl, cl, dl, w[  9 ], 15, 0x5A827999 );
+  STEP( F3, er, ar, br, cr, dr, w[  8 ], 12, 0x5C4DD124 );
+  STEP( F1, dl, el, al, bl, cl, w[  5 ],  9, 0x5A827999 );
+  STEP( F3, dr, er, ar, br, cr, w[ 12 ],  7, 0x5C4DD124 );
+  STEP( F1, cl, dl, el, al, bl, w[  2 ], 11, 0x5A827999 );
+  STEP( F3, cr, dr, er, ar, br, w[  4 ],  6, 0x5C4DD124 );
+  STEP( F1, bl, cl, dl, el, al, w[ 14 ],  7, 0x5A827999 );
+  STEP( F3, br, cr, dr, er, ar, w[  9 ], 15, 0x5C4DD124 );
+  STEP( F1, al, bl, cl, dl, el, w[ 11 ], 13, 0x5A827999 );
+  STEP( F3, ar, br, cr, dr, er, w[  1 ], 13, 0x5C4DD124 );
+  STEP( F1, el, al, bl, cl, dl, w[  8 ], 12, 0x5A827999 );
+  STEP( F3, er, ar, br, cr, dr, w[  2 ], 11, 0x5C4DD124 );
+
+  // round 2, left side uses F2 and right side uses F2
+  STEP( F2, dl, el, al, bl, cl, w[  3 ], 11, 0x6ED9EBA1 );
+  STEP( F2, dr, er, ar, br, cr, w[ 15 ],  9, 0x6D703EF3 );
+  STEP( F2, cl, dl, el, al, bl, w[ 10 ], 13, 0x6ED9EBA1 );
+  STEP( F2, cr, dr, er, ar, br, w[  5 ],  7, 0x6D703EF3 );
+  STEP( F2, bl, cl, dl, el, al, w[ 14 ],  6, 0x6ED9EBA1 );
+  STEP( F2, br, cr, dr, er, ar, w[  1 ], 15, 0x6D703EF3 );
+  STEP( F2, al, bl, cl, dl, el, w[  4 ],  7, 0x6ED9EBA1 );
+  STEP( F2, ar, br, cr, dr, er, w[  3 ], 11, 0x6D703EF3 );
+  STEP( F2, el, al, bl, cl, dl, w[  9 ], 14, 0x6ED9EBA1 );
+  STEP( F2, er, ar, br, cr, dr, w[  7 ],  8, 0x6D703EF3 );
+  STEP( F2, dl, el, al, bl, cl, w[ 15 ],  9, 0x6ED9EBA1 );
+  STEP( F2, dr, er, ar, br, cr, w[ 14 ],  6, 0x6D703EF3 );
+  STEP( F2, cl, dl, el, al, bl, w[  8 ], 13, 0x6ED9EBA1 );
+  STEP( F2, cr, dr, er, ar, br, w[  6 ],  6, 0x6D703EF3 );
+  STEP( F2, bl, cl, dl, el, al, w[  1 ], 15, 0x6ED9EBA1 );
+  STEP( F2, br, cr, dr, er, ar, w[  9 ], 14, 0x6D703EF3 );
+  STEP( F2, al, bl, cl, dl, el, w[  2 ], 14, 0x6ED9EBA1 );
+  STEP( F2, ar, br, cr, dr, er, w[ 11 ], 12, 0x6D703EF3 );
+  STEP( F2, el, al, bl, cl, dl, w[  7 ],  8, 0x6ED9EBA1 );
+  STEP( F2, er, ar, br, cr, dr, w[  8 ], 13, 0x6D703EF3 );
+  STEP( F2, dl, el, al, bl, cl, w[  0 ], 13, 0x6ED9EBA1 );
+  STEP( F2, dr, er, ar, br, cr, w[ 12 ],  5, 0x6D703EF3 );
+  STEP( F2, cl, dl, el, al, bl, w[  6 ],  6, 0x6ED9EBA1 );
+  STEP( F2, cr, dr, er, ar, br, w[  2 ], 14, 0x6D703EF3 );
+  STEP( F2, bl, cl, dl, el, al, w[ 13 ],  5, 0x6ED9EBA1 );
+  STEP( F2, br, cr, dr, er, ar, w[ 10 ], 13, 0x6D703EF3 );
+  STEP( F2, al, bl, cl, dl, el, w[ 11 ], 12, 0x6ED9EBA1 );
+  STEP( F2, ar, br, cr, dr, er, w[  0 ], 13, 0x6D703EF3 );
+  STEP( F2, el, al, bl, cl, dl, w[  5 ],  7, 0x6ED9EBA1 );
+  STEP( F2, er, ar, br, cr, dr, w[  4 ],  7, 0x6D703EF3 );
+  STEP( F2, dl, el, al, bl, cl, w[ 12 ],  5, 0x6ED9EBA1 );
+  STEP( F2, dr, er, ar, br, cr, w[ 13 ],  5, 0x6D703EF3 );
+
+  // round 3, left side uses F3 and right side uses F1
+  STEP( F3, cl, dl, el, al, bl, w[  1 ], 11, 0x8F1BBCDC );
+  STEP( F1, cr, dr, er, ar, br, w[  8 ], 15, 0x7A6D76E9 );
+  STEP( F3, bl, cl, dl, el, al, w[  9 ], 12, 0x8F1BBCDC );
+  STEP( F1, br, cr, dr, er, ar, w[  6 ],  5, 0x7A6D76E9 );
+  STEP( F3, al, bl, cl, dl, el, w[ 11 ], 14, 0x8F1BBCDC );
+  STEP( F1, ar, br, cr, dr, er, w[  4 ],  8, 0x7A6D76E9 );
+  STEP( F3, el, al, bl, cl, dl, w[ 10 ], 15, 0x8F1BBCDC );
+  STEP( F1, er, ar, br, cr, dr, w[  1 ], 11, 0x7A6D76E9 );
+  STEP( F3, dl, el, al, bl, cl, w[  0 ], 14, 0x8F1BBCDC );
+  STEP( F1, dr, er, ar, br, cr, w[  3 ], 14, 0x7A6D76E9 );
+  STEP( F3, cl, dl, el, al, bl, w[  8 ], 15, 0x8F1BBCDC );
+  STEP( F1, cr, dr, er, ar, br, w[ 11 ], 14, 0x7A6D76E9 );
+  STEP( F3, bl, cl, dl, el, al, w[ 12 ],  9, 0x8F1BBCDC );
+  STEP( F1, br, cr, dr, er, ar, w[ 15 ],  6, 0x7A6D76E9 );
+  STEP( F3, al, bl, cl, dl, el, w[  4 ],  8, 0x8F1BBCDC );
+  STEP( F1, ar, br, cr, dr, er, w[  0 ], 14, 0x7A6D76E9 );
+  STEP( F3, el, al, bl, cl, dl, w[ 13 ],  9, 0x8F1BBCDC );
+  STEP( F1, er, ar, br, cr, dr, w[  5 ],  6, 0x7A6D76E9 );
+  STEP( F3, dl, el, al, bl, cl, w[  3 ], 14, 0x8F1BBCDC );
+  STEP( F1, dr, er, ar, br, cr, w[ 12 ],  9, 0x7A6D76E9 );
+  STEP( F3, cl, dl, el, al, bl, w[  7 ],  5, 0x8F1BBCDC );
+  STEP( F1, cr, dr, er, ar, br, w[  2 ], 12, 0x7A6D76E9 );
+  STEP( F3, bl, cl, dl, el, al, w[ 15 ],  6, 0x8F1BBCDC );
+  STEP( F1, br, cr, dr, er, ar, w[ 13 ],  9, 0x7A6D76E9 );
+  STEP( F3, al, bl, cl, dl, el, w[ 14 ],  8, 0x8F1BBCDC );
+  STEP( F1, ar, br, cr, dr, er, w[  9 ], 12, 0x7A6D76E9 );
+  STEP( F3, el, al, bl, cl, dl, w[  5 ],  6, 0x8F1BBCDC );
+  STEP( F1, er, ar, br, cr, dr, w[  7 ],  5, 0x7A6D76E9 );
+  STEP( F3, dl, el, al, bl, cl, w[  6 ],  5, 0x8F1BBCDC );
+  STEP( F1, dr, er, ar, br, cr, w[ 10 ], 15, 0x7A6D76E9 );
+  STEP( F3, cl, dl, el, al, bl, w[  2 ], 12, 0x8F1BBCDC );
+  STEP( F1, cr, dr, er, ar, br, w[ 14 ],  8, 0x7A6D76E9 );
+
+  // round 4, left side uses F4 and right side uses F0
+  STEP( F4, bl, cl, dl, el, al, w[  4 ],  9, 0xA953FD4E );
+  STEP( F0, br, cr, dr, er, ar, w[ 12 ],  8, 0x00000000 );
+  STEP( F4, al, bl, cl, dl, el, w[  0 ], 15, 0xA953FD4E );
+  STEP( F0, ar, br, cr, dr, er, w[ 15 ],  5, 0x00000000 );
+  STEP( F4, el, al, bl, cl, dl, w[  5 ],  5, 0xA953FD4E );
+  STEP( F0, er, ar, br, cr, dr, w[ 10 ], 12, 0x00000000 );
+  STEP( F4, dl, el, al, bl, cl, w[  9 ], 11, 0xA953FD4E );
+  STEP( F0, dr, er, ar, br, cr, w[  4 ],  9, 0x00000000 );
+  STEP( F4, cl, dl, el, al, bl, w[  7 ],  6, 0xA953FD4E );
+  STEP( F0, cr, dr, er, ar, br, w[  1 ], 12, 0x00000000 );
+  STEP( F4, bl, cl, dl, el, al, w[ 12 ],  8, 0xA953FD4E );
+  STEP( F0, br, cr, dr, er, ar, w[  5 ],  5, 0x00000000 );
+  STEP( F4, al, bl, cl, dl, el, w[  2 ], 13, 0xA953FD4E );
+  STEP( F0, ar, br, cr, dr, er, w[  8 ], 14, 0x00000000 );
+  STEP( F4, el, al, bl, cl, dl, w[ 10 ], 12, 0xA953FD4E );
+  STEP( F0, er, ar, br, cr, dr, w[  7 ],  6, 0x00000000 );
+  STEP( F4, dl, el, al, bl, cl, w[ 14 ],  5, 0xA953FD4E );
+  STEP( F0, dr, er, ar, br, cr, w[  6 ],  8, 0x00000000 );
+  STEP( F4, cl, dl, el, al, bl, w[  1 ], 12, 0xA953FD4E );
+  STEP( F0, cr, dr, er, ar, br, w[  2 ], 13, 0x00000000 );
+  STEP( F4, bl, cl, dl, el, al, w[  3 ], 13, 0xA953FD4E );
+  STEP( F0, br, cr, dr, er, ar, w[ 13 ],  6, 0x00000000 );
+  STEP( F4, al, bl, cl, dl, el, w[  8 ], 14, 0xA953FD4E );
+  STEP( F0, ar, br, cr, dr, er, w[ 14 ],  5, 0x00000000 );
+  STEP( F4, el, al, bl, cl, dl, w[ 11 ], 11, 0xA953FD4E );
+  STEP( F0, er, ar, br, cr, dr, w[  0 ], 15, 0x00000000 );
+  STEP( F4, dl, el, al, bl, cl, w[  6 ],  8, 0xA953FD4E );
+  STEP( F0, dr, er, ar, br, cr, w[  3 ], 13, 0x00000000 );
+  STEP( F4, cl, dl, el, al, bl, w[ 15 ],  5, 0xA953FD4E );
+  STEP( F0, cr, dr, er, ar, br, w[  9 ], 11, 0x00000000 );
+  STEP( F4, bl, cl, dl, el, al, w[ 13 ],  6, 0xA953FD4E );
+  STEP( F0, br, cr, dr, er, ar, w[ 11 ], 11, 0x00000000 );
@@ -0,0 +1,189 @@
+/**
+ * @file sha256.c
+ * @author Jake Donovan (jmpatte8)
+ * This file is responsible for SHA-256, as described in FIPS 180-4.  Unlike RIPEMD, SHA-256 reads
+ * its message words and writes its digest big-endian.
+*/
+
+#include "sha256.h"
+#include <string.h>
+
+/** Round constants, the first 32 bits of the fractional parts of the cube roots of the first
+    64 primes */
+static longword const roundK[ SHA_ROUNDS ] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+/** Rotate a longword right by a constant number of bits */
+#define ROTR( x, s ) ( ( ( x ) >> ( s ) ) | ( ( x ) << ( LW_BITS - ( s ) ) ) )
+
+/**
+ * This function loads a big-endian longword from any address
+ * @param p where the longword starts
+ * @return the longword
+*/
+static inline longword loadBig( byte const *p )
+{
+  return ( longword )p[ 0 ] << ( 3 * BBITS ) | ( longword )p[ 1 ] << ( 2 * BBITS ) |
+    ( longword )p[ 2 ] << BBITS | ( longword )p[ 3 ];
+}
+
+/**
+ * This function processes a run of whole blocks, updating the state
+ * @param state the input state, replaced with the output state
+ * @param data the first block
+ * @param nblocks the number of blocks
+*/
+void shaBlocks( longword state[ SHA_STATE_WORDS ], byte const *data, size_t nblocks )
+{
+  for( ; nblocks > 0; nblocks--, data += BLOCK_BYTES ){
+    longword w[ SHA_ROUNDS ];
+    for( int i = 0; i < BLOCK_LONGWORDS; i++ ){
+      w[ i ] = loadBig( data + LW_BYTES * i );
+    }
+    for( int i = BLOCK_LONGWORDS; i < SHA_ROUNDS; i++ ){
+      longword s0 = ROTR( w[ i - 15 ], 7 ) ^ ROTR( w[ i - 15 ], 18 ) ^ ( w[ i - 15 ] >> 3 );
+      longword s1 = ROTR( w[ i - 2 ], 17 ) ^ ROTR( w[ i - 2 ], 19 ) ^ ( w[ i - 2 ] >> 10 );
+      w[ i ] = w[ i - 16 ] + s0 + w[ i - 7 ] + s1;
+    }
+
+    longword a = state[ 0 ], b = state[ 1 ], c = state[ 2 ], d = state[ 3 ];
+    longword e = state[ 4 ], f = state[ 5 ], g = state[ 6 ], h = state[ 7 ];
+    for( int i = 0; i < SHA_ROUNDS; i++ ){
+      longword t1 = h + ( ROTR( e, 6 ) ^ ROTR( e, 11 ) ^ ROTR( e, 25 ) ) + ( ( e & f ) ^ ( ~e & g ) ) +
+        roundK[ i ] + w[ i ];
+      longword t2 = ( ROTR( a, 2 ) ^ ROTR( a, 13 ) ^ ROTR( a, 22 ) ) + ( ( a & b ) ^ ( a & c ) ^ ( b & c ) );
+      h = g;
+      g = f;
+      f = e;
+      e = d + t1;
+      d = c;
+      c = b;
+      b = a;
+      a = t1 + t2;
+    }
+
+    state[ 0 ] += a;
+    state[ 1 ] += b;
+    state[ 2 ] += c;
+    state[ 3 ] += d;
+    state[ 4 ] += e;
+    state[ 5 ] += f;
+    state[ 6 ] += g;
+    state[ 7 ] += h;
+  }
+}
+
+/**
+ * This function sets a state to the initial one, the first 32 bits of the fractional parts of the
+ * square roots of the first 8 primes
+ * @param state the state to initialize
+*/
+void shaInitState( longword state[ SHA_STATE_WORDS ] )
+{
+  static longword const initial[ SHA_STATE_WORDS ] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+  };
+
+  memcpy( state, initial, sizeof( initial ) );
+}
+
+/**
+ * This function gets a streaming context ready to hash a new input, starting with the initial state
+ * and an empty block
+ * @param ctx the context to initialize
+*/
+void shaInit( ShaCtx *ctx )
+{
+  shaInitState( ctx->state );
+  ctx->blockLen = 0;
+  ctx->total = 0;
+}
+
+/**
+ * This function adds more input to a streaming hash, the same way ripeUpdate() does
+ * @param ctx the streaming context
+ * @param data the next bytes of input
+ * @param len the number of bytes in data
+*/
+void shaUpdate( ShaCtx *ctx, byte const *data, size_t len )
+{
+  ctx->total += len;
+
+  // finish off a block left over from last time
+  if( ctx->blockLen > 0 ){
+    size_t n = BLOCK_BYTES - ctx->blockLen;
+    if( n > len ){
+      n = len;
+    }
+
+    memcpy( ctx->block + ctx->blockLen, data, n );
+    ctx->blockLen += n;
+    data += n;
+    len -= n;
+
+    if( ctx->blockLen < BLOCK_BYTES ){
+      return;
+    }
+
+    shaBlocks( ctx->state, ctx->block, 1 );
+    ctx->blockLen = 0;
+  }
+
+  // hash whole blocks in place
+  size_t whole = len / BLOCK_BYTES;
+  shaBlocks( ctx->state, data, whole );
+  data += whole * BLOCK_BYTES;
+  len -= whole * BLOCK_BYTES;
+
+  // save the rest for later
+  memcpy( ctx->block, data, len );
+  ctx->blockLen = len;
+}
+
+/**
+ * This function writes a state out as a digest, each longword high-order byte first
+ * @param state the final state
+ * @param digest room for the digest
+*/
+void shaDigest( longword const state[ SHA_STATE_WORDS ], byte digest[ SHA_DIGEST_BYTES ] )
+{
+  for( int i = 0; i < SHA_STATE_WORDS; i++ ){
+    for( int j = 0; j < LW_BYTES; j++ ){
+      digest[ i * LW_BYTES + j ] = state[ i ] >> ( ( LW_BYTES - 1 - j ) * BBITS );
+    }
+  }
+}
+
+/**
+ * This function finishes a streaming hash. The padding is the same as for RIPEMD, except that the
+ * length in bits goes at the end high-order byte first
+ * @param ctx the streaming context, which has to be initialized again before it's reused
+ * @param digest room for the digest
+*/
+void shaFinal( ShaCtx *ctx, byte digest[ SHA_DIGEST_BYTES ] )
+{
+  unsigned long long bits = ctx->total * BBITS;
+
+  // if there's no room left for the length, it goes in a block of its own
+  byte tail[ 2 * BLOCK_BYTES ];
+  int blocks = ctx->blockLen > SHA_ONE_BLOCK_MAX ? 2 : 1;
+  int end = blocks * BLOCK_BYTES;
+
+  memcpy( tail, ctx->block, ctx->blockLen );
+  tail[ ctx->blockLen ] = 0x80;
+  memset( tail + ctx->blockLen + 1, 0x00, end - BBITS - ctx->blockLen - 1 );
+  for( int i = 0; i < BBITS; i++ ){
+    tail[ end - 1 - i ] = bits >> ( i * BBITS );
+  }
+
+  shaBlocks( ctx->state, tail, blocks );
+  shaDigest( ctx->state, digest );
+}
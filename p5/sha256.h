@@ -0,0 +1,54 @@
+/**
+ * @file sha256.h
+ * @author Jake Donovan (jmpatte8)
+ * This header file is for SHA-256, which is hashed before RIPEMD-160 in HASH160.  It has the same
+ * kind of streaming interface as ripeMD.h, and uses the same byte and longword types.
+*/
+
+#ifndef _SHA256_H_
+/** Our SHA-256 header */
+#define _SHA256_H_
+
+#include "ripeMD.h"
+
+/** Number of bytes in a SHA-256 digest */
+#define SHA_DIGEST_BYTES 32
+
+/** Number of longwords in a SHA-256 state */
+#define SHA_STATE_WORDS 8
+
+/** Number of rounds in the SHA-256 compression function */
+#define SHA_ROUNDS 64
+
+/** Most bytes of message that fit in one block along with the padding */
+#define SHA_ONE_BLOCK_MAX ( BLOCK_BYTES - 1 - BBITS )
+
+/** Streaming SHA-256 computation, like RipeCtx */
+typedef struct {
+  /** State of the hash after every complete block so far */
+  longword state[ SHA_STATE_WORDS ];
+
+  /** Bytes of input that don't make a whole block yet */
+  byte block[ BLOCK_BYTES ];
+
+  /** Number of bytes in block */
+  unsigned int blockLen;
+
+  /** Total number of bytes of input so far */
+  unsigned long long total;
+} ShaCtx;
+
+/** shaBlocks function prototype */
+void shaBlocks( longword state[ SHA_STATE_WORDS ], byte const *data, size_t nblocks );
+/** shaInitState function prototype */
+void shaInitState( longword state[ SHA_STATE_WORDS ] );
+/** shaInit function prototype */
+void shaInit( ShaCtx *ctx );
+/** shaUpdate function prototype */
+void shaUpdate( ShaCtx *ctx, byte const *data, size_t len );
+/** shaFinal function prototype */
+void shaFinal( ShaCtx *ctx, byte digest[ SHA_DIGEST_BYTES ] );
+/** shaDigest function prototype */
+void shaDigest( longword const state[ SHA_STATE_WORDS ], byte digest[ SHA_DIGEST_BYTES ] );
+
+#endif
@@ -1,7 +1,7 @@
 /** 
     @file testdriver.c
 
-    This is a test driver for code in the byteBuffer and ripeMD components.
+    This is a test driver for code in the byteBuffer, ripeMD, sha256 and hash160 components.
 */
 
 #include <stdlib.h>
@@ -9,6 +9,9 @@
 #include <string.h>
 #include "byteBuffer.h"
 #include "ripeMD.h"
+#include "ripeMulti.h"
+#include "sha256.h"
+#include "hash160.h"
 
 /** Total number or tests we tried. */
 static int totalTests = 0;
@@ -17,7 +20,16 @@ static int totalTests = 0;
 static int passedTests = 0;
 
 /** Number of tests we should have, if they're all turned on. */
-#define EXPECTED_TOTAL 97
+#define EXPECTED_TOTAL 136
+
+/** Number of extra tests run on a big input file, if BIG_INPUT names one. */
+#define BIG_TESTS 4
+
+/** Number of zero bytes at the start of the big input file. */
+#define BIG_INPUT_LEN ( 4ull << 30 )
+
+/** Number of tests we should have, including any on a big input file. */
+static int expectedTotal = EXPECTED_TOTAL;
 
 /** Macro to check the condition on a test case, keep counts of
     passed/failed tests and report a message if the test fails. */
@@ -103,6 +115,45 @@ int main()
     freeBuffer( buffer );
   }
 
+  ////////////////////////////////////////////////////////////////////////
+  // Test reserve(), appendBytes() and appendFill()
+
+  {
+    ByteBuffer *buffer = createBuffer();
+
+    // Reserving room grows the buffer once, without changing its length.
+    reserve( buffer, 100 );
+    TestCase( buffer->len == 0 );
+    TestCase( buffer->cap >= 100 );
+
+    // There's already room, so the capacity shouldn't change.
+    size_t cap = buffer->cap;
+    reserve( buffer, 50 );
+    TestCase( buffer->cap == cap );
+
+    appendBytes( buffer, ( byte const * )"abcdef", 6 );
+    TestCase( buffer->len == 6 );
+    TestCase( memcmp( buffer->data, "abcdef", 6 ) == 0 );
+
+    appendFill( buffer, 'z', 94 );
+    TestCase( buffer->len == 100 );
+    TestCase( buffer->data[ 6 ] == 'z' && buffer->data[ 99 ] == 'z' );
+    TestCase( buffer->cap == cap );
+
+    // Appending past the capacity should at least double it.
+    appendFill( buffer, 'q', 1 );
+    TestCase( buffer->len == 101 );
+    TestCase( buffer->cap >= cap * 2 );
+    TestCase( buffer->data[ 100 ] == 'q' );
+
+    // Appending nothing is fine too.
+    appendBytes( buffer, ( byte const * )"", 0 );
+    appendFill( buffer, 'x', 0 );
+    TestCase( buffer->len == 101 );
+
+    freeBuffer( buffer );
+  }
+
   ////////////////////////////////////////////////////////////////////////
   // Test readFile()
   
@@ -156,6 +207,32 @@ int main()
     TestCase( buffer == NULL );
   }
 
+  {
+    // Optionally, try a file too big for 32-bit lengths.  It's all zeros
+    // except for a line of text at the end.
+    char const *big = getenv( "BIG_INPUT" );
+    if ( big ) {
+      char const *tail = "This is the end of a big input file.\n";
+      size_t tailLen = strlen( tail );
+      size_t bigLen = BIG_INPUT_LEN + tailLen;
+
+      ByteBuffer *buffer = readFile( big );
+      TestCase( buffer != NULL );
+      TestCase( buffer->len == bigLen );
+      TestCase( memcmp( buffer->data + buffer->len - tailLen, tail, tailLen ) == 0 );
+
+      // The length in bits at the end of the padding needs all 64 bits.
+      padBuffer( buffer );
+      unsigned long long bits = 0;
+      for ( int i = 0; i < 8; i++ )
+        bits |= (unsigned long long) buffer->data[ buffer->len - 8 + i ] << ( i * 8 );
+      TestCase( buffer->len % BLOCK_BYTES == 0 && bits == bigLen * 8ull );
+
+      freeBuffer( buffer );
+      expectedTotal += BIG_TESTS;
+    }
+  }
+
   ////////////////////////////////////////////////////////////////////////
   // Tests for the ripeMD component
   ////////////////////////////////////////////////////////////////////////
@@ -553,14 +630,288 @@ int main()
     TestCase( state.E == 0x639BEE89 );
   }
 
+  ////////////////////////////////////////////////////////////////////////
+  // Test the unrolled hashBlock() against the table-driven version
+
+  {
+    // Random-looking states and blocks, from a simple generator.
+    unsigned int seed = 12345;
+    int same = 0;
+    for ( int k = 0; k < 1000; k++ ) {
+      HashState state;
+      longword *field = &state.A;
+      for ( int i = 0; i < 5; i++ ) {
+        seed = seed * 1103515245 + 12345;
+        field[ i ] = seed;
+      }
+
+      byte data[ BLOCK_BYTES ];
+      for ( int i = 0; i < BLOCK_BYTES; i++ ) {
+        seed = seed * 1103515245 + 12345;
+        data[ i ] = seed >> 24;
+      }
+
+      HashState expected = state;
+      hashBlockTableWrapper( &expected, data );
+      hashBlock( &state, data );
+      if ( memcmp( &state, &expected, sizeof( state ) ) == 0 )
+        same++;
+    }
+
+    TestCase( same == 1000 );
+  }
+
+  ////////////////////////////////////////////////////////////////////////
+  // Test hashBlocks() on unaligned data against one block at a time
+
+  {
+    // Start one byte in, so no block is aligned.
+    int blocks = 7;
+    byte *raw = (byte *) malloc( blocks * BLOCK_BYTES + 1 );
+    for ( int i = 0; i < blocks * BLOCK_BYTES + 1; i++ )
+      raw[ i ] = i * 31 + 7;
+    byte *data = raw + 1;
+
+    HashState expected, state;
+    initState( &expected );
+    for ( int i = 0; i < blocks; i++ ) {
+      byte block[ BLOCK_BYTES ];
+      memcpy( block, data + i * BLOCK_BYTES, BLOCK_BYTES );
+      hashBlockTableWrapper( &expected, block );
+    }
+
+    initState( &state );
+    hashBlocks( &state, data, blocks );
+    TestCase( memcmp( &state, &expected, sizeof( state ) ) == 0 );
+
+    // No blocks at all leaves the state alone.
+    hashBlocks( &state, data, 0 );
+    TestCase( memcmp( &state, &expected, sizeof( state ) ) == 0 );
+
+    free( raw );
+  }
+
+  ////////////////////////////////////////////////////////////////////////
+  // Test the multi-buffer engines against the streaming functions
+
+  {
+    // Messages of many different lengths, so lanes finish at different
+    // times and get refilled.
+    int count = 300;
+    byte *data = (byte *) malloc( count );
+    for ( int i = 0; i < count; i++ )
+      data[ i ] = i * 73 + 5;
+
+    RipeJob *jobs = (RipeJob *) malloc( count * sizeof( RipeJob ) );
+    HashState *expected = (HashState *) malloc( count * sizeof( HashState ) );
+    for ( int i = 0; i < count; i++ ) {
+      jobs[ i ].data = data + i % 7;
+      jobs[ i ].len = ( i * 37 ) % ( count - 7 );
+
+      RipeCtx ctx;
+      ripeInit( &ctx );
+      ripeUpdate( &ctx, jobs[ i ].data, jobs[ i ].len );
+      ripeFinal( &ctx, expected + i );
+    }
+
+    // Try each engine, or the best one if this processor can't run it.
+    char const *names[] = { "scalar", "sse2", "avx2" };
+    for ( int e = 0; e < sizeof( names ) / sizeof( names[ 0 ] ); e++ ) {
+      ripeSetEngine( NULL );
+      ripeSetEngine( names[ e ] );
+      ripeMany( jobs, count );
+
+      int same = 0;
+      for ( int i = 0; i < count; i++ )
+        if ( memcmp( &jobs[ i ].digest, expected + i, sizeof( HashState ) ) == 0 )
+          same++;
+      TestCase( same == count );
+    }
+
+    // Fewer messages than lanes, and none at all.
+    ripeSetEngine( NULL );
+    ripeMany( jobs, 3 );
+    TestCase( memcmp( &jobs[ 2 ].digest, expected + 2, sizeof( HashState ) ) == 0 );
+    ripeMany( jobs, 0 );
+
+    free( expected );
+    free( jobs );
+    free( data );
+  }
+
+  ////////////////////////////////////////////////////////////////////////
+  // Test the streaming functions against padBuffer() and hashBlock()
+
+  {
+    // Hash a whole file the old way.
+    ByteBuffer *buffer = readFile( "input-03.txt" );
+    unsigned int fileLen = buffer->len;
+    padBuffer( buffer );
+
+    HashState expected;
+    initState( &expected );
+    for ( int i = 0; i < buffer->len; i += BLOCK_BYTES )
+      hashBlock( &expected, buffer->data + i );
+
+    // Then in pieces of a few different sizes, some that split blocks.
+    int pieces[] = { 1, 7, 64, 100, 909 };
+    for ( int p = 0; p < sizeof( pieces ) / sizeof( pieces[ 0 ] ); p++ ) {
+      RipeCtx ctx;
+      ripeInit( &ctx );
+      for ( int i = 0; i < fileLen; i += pieces[ p ] ) {
+        int n = fileLen - i < pieces[ p ] ? fileLen - i : pieces[ p ];
+        ripeUpdate( &ctx, buffer->data + i, n );
+      }
+
+      HashState state;
+      ripeFinal( &ctx, &state );
+      TestCase( memcmp( &state, &expected, sizeof( state ) ) == 0 );
+    }
+
+    freeBuffer( buffer );
+  }
+
+  {
+    // Lengths right around where the padding needs an extra block.
+    byte data[ 2 * BLOCK_BYTES ];
+    for ( int i = 0; i < sizeof( data ); i++ )
+      data[ i ] = i * 37;
+
+    int lens[] = { 0, 55, 56, 63, 64, 120 };
+    for ( int k = 0; k < sizeof( lens ) / sizeof( lens[ 0 ] ); k++ ) {
+      ByteBuffer *buffer = createBuffer();
+      for ( int i = 0; i < lens[ k ]; i++ )
+        addByte( buffer, data[ i ] );
+      padBuffer( buffer );
+
+      HashState expected;
+      initState( &expected );
+      for ( int i = 0; i < buffer->len; i += BLOCK_BYTES )
+        hashBlock( &expected, buffer->data + i );
+
+      RipeCtx ctx;
+      ripeInit( &ctx );
+      ripeUpdate( &ctx, data, lens[ k ] );
+
+      HashState state;
+      ripeFinal( &ctx, &state );
+      TestCase( memcmp( &state, &expected, sizeof( state ) ) == 0 );
+
+      freeBuffer( buffer );
+    }
+  }
+
+  {
+    // SHA-256 test vectors from FIPS 180-4, including one that needs a second block for the padding.
+    char const *msgs[] = { "", "abc", "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq" };
+    char const *digests[] = {
+      "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855",
+      "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad",
+      "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"
+    };
+
+    for ( int k = 0; k < sizeof( msgs ) / sizeof( msgs[ 0 ] ); k++ ) {
+      ShaCtx ctx;
+      shaInit( &ctx );
+      shaUpdate( &ctx, ( byte const * )msgs[ k ], strlen( msgs[ k ] ) );
+
+      byte digest[ SHA_DIGEST_BYTES ];
+      shaFinal( &ctx, digest );
+
+      char hex[ 2 * SHA_DIGEST_BYTES + 1 ];
+      for ( int i = 0; i < SHA_DIGEST_BYTES; i++ )
+        sprintf( hex + 2 * i, "%02x", digest[ i ] );
+      TestCase( strcmp( hex, digests[ k ] ) == 0 );
+    }
+  }
+
+  {
+    // SHA-256 fed a few bytes at a time, against all at once.
+    byte data[ 2 * BLOCK_BYTES + 9 ];
+    for ( int i = 0; i < sizeof( data ); i++ )
+      data[ i ] = i * 37;
+
+    byte expected[ SHA_DIGEST_BYTES ];
+    ShaCtx ctx;
+    shaInit( &ctx );
+    shaUpdate( &ctx, data, sizeof( data ) );
+    shaFinal( &ctx, expected );
+
+    byte digest[ SHA_DIGEST_BYTES ];
+    shaInit( &ctx );
+    for ( int i = 0; i < sizeof( data ); i += 5 )
+      shaUpdate( &ctx, data + i, sizeof( data ) - i < 5 ? sizeof( data ) - i : 5 );
+    shaFinal( &ctx, digest );
+    TestCase( memcmp( digest, expected, SHA_DIGEST_BYTES ) == 0 );
+  }
+
+  {
+    // HASH160 of a compressed public key, and of the empty string.
+    byte key[] = {
+      0x02, 0x50, 0x86, 0x3a, 0xd6, 0x4a, 0x87, 0xae, 0x8a, 0x2f, 0xe8, 0x3c, 0x1a, 0xf1, 0xa8, 0x40,
+      0x3c, 0xb5, 0x3f, 0x53, 0xe4, 0x86, 0xd8, 0x51, 0x1d, 0xad, 0x8a, 0x04, 0x88, 0x7e, 0x5b, 0x23,
+      0x52
+    };
+    byte keyHash[ HASH160_BYTES ] = {
+      0xf5, 0x4a, 0x58, 0x51, 0xe9, 0x37, 0x2b, 0x87, 0x81, 0x0a, 0x8e, 0x60, 0xcd, 0xd2, 0xe7, 0xcf,
+      0xd8, 0x0b, 0x6e, 0x31
+    };
+    byte emptyHash[ HASH160_BYTES ] = {
+      0xb4, 0x72, 0xa2, 0x66, 0xd0, 0xbd, 0x89, 0xc1, 0x37, 0x06, 0xa4, 0x13, 0x2c, 0xcf, 0xb1, 0x6f,
+      0x7c, 0x3b, 0x9f, 0xcb
+    };
+
+    byte out[ HASH160_BYTES ];
+    hash160( key, sizeof( key ), out );
+    TestCase( memcmp( out, keyHash, HASH160_BYTES ) == 0 );
+
+    hash160( key, 0, out );
+    TestCase( memcmp( out, emptyHash, HASH160_BYTES ) == 0 );
+  }
+
+  {
+    // The RIPEMD-160 half of HASH160, against hashing the SHA-256 digest the usual way.
+    byte data[ 100 ];
+    for ( int i = 0; i < sizeof( data ); i++ )
+      data[ i ] = i * 11;
+
+    int lens[] = { 1, 55, 56 };
+    for ( int k = 0; k < sizeof( lens ) / sizeof( lens[ 0 ] ); k++ ) {
+      ShaCtx ctx;
+      shaInit( &ctx );
+      shaUpdate( &ctx, data, lens[ k ] );
+
+      byte sha[ SHA_DIGEST_BYTES ];
+      shaFinal( &ctx, sha );
+
+      RipeCtx ripe;
+      ripeInit( &ripe );
+      ripeUpdate( &ripe, sha, SHA_DIGEST_BYTES );
+
+      HashState state;
+      ripeFinal( &ripe, &state );
+
+      char expected[ HASH_CHARS + 1 ];
+      hashString( &state, expected );
+
+      byte out[ HASH160_BYTES ];
+      hash160( data, lens[ k ], out );
+
+      char hex[ HASH_CHARS + 1 ];
+      for ( int i = 0; i < HASH160_BYTES; i++ )
+        sprintf( hex + 2 * i, "%02x", out[ i ] );
+      TestCase( strcmp( hex, expected ) == 0 );
+    }
+  }
+
   #endif
 
   printf( "You passed %d / %d unit tests\n", passedTests, totalTests );
 
-  if ( totalTests != EXPECTED_TOTAL )
-    printf( "The full test driver should have %d tests\n", EXPECTED_TOTAL );
+  if ( totalTests != expectedTotal )
+    printf( "The full test driver should have %d tests\n", expectedTotal );
 
-  if ( passedTests != EXPECTED_TOTAL )
+  if ( passedTests != expectedTotal )
     return EXIT_FAILURE;
   else
     return EXIT_SUCCESS;
@@ -0,0 +1,524 @@
+/**
+ * @file treeHash.c
+ * @author Jake Donovan (jmpatte8)
+ * This file is responsible for hashing whole directory trees.  The main thread walks the tree and
+ * deals each regular file it finds to one of the worker threads' deques.  A worker takes files from
+ * its own deque first, and steals from the others once it runs out, so a worker that drew a few big
+ * files doesn't leave the rest waiting.  Each directory's entries are visited in sorted order, so the
+ * files are found in path order, and the manifest is printed as the hashes come in.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "treeHash.h"
+#include "fileHash.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/** A file found in the tree, and its hash once a worker is done with it */
+typedef struct {
+  /** Path to the file */
+  char *path;
+
+  /** Size of the file when it was found */
+  off_t size;
+
+  /** Final hash state, if the file was hashed */
+  HashState state;
+
+  /** Zero if the file was hashed, or the errno value saying why it wasn't */
+  int err;
+
+  /** True once a worker has finished with the file */
+  bool done;
+} Entry;
+
+/** A worker's files, as a growable ring with its own lock */
+typedef struct {
+  /** Files waiting to be hashed */
+  Entry **items;
+
+  /** Capacity of the items array */
+  int cap;
+
+  /** Index of the oldest file */
+  int first;
+
+  /** Number of files in the deque */
+  int len;
+
+  /** Lock for this deque */
+  pthread_mutex_t lock;
+} Deque;
+
+/** Everything shared by the walk and the workers */
+typedef struct {
+  /** Every file found so far, in path order; only the main thread uses this list */
+  Entry **entries;
+
+  /** Number of files found */
+  int count;
+
+  /** Capacity of the entries array */
+  int cap;
+
+  /** Index of the next entry to print */
+  int printed;
+
+  /** One deque for each worker */
+  Deque *deques;
+
+  /** Number of workers */
+  int workers;
+
+  /** Number of files in all the deques */
+  int queued;
+
+  /** True once the walk is over */
+  bool walked;
+
+  /** Function that hashes each file */
+  FileHasher hasher;
+
+  /** Lock for queued, walked and the done flags */
+  pthread_mutex_t lock;
+
+  /** Signaled when files are queued or the walk is over */
+  pthread_cond_t more;
+
+  /** Signaled whenever a file is done */
+  pthread_cond_t finished;
+} Tree;
+
+/** A worker thread and the tree it's working on */
+typedef struct {
+  /** The shared tree */
+  Tree *tree;
+
+  /** Index of this worker's own deque */
+  int id;
+} Worker;
+
+/**
+ * This function adds a file to the newest end of a deque
+ * @param d the deque
+ * @param e the file to add
+*/
+static void pushBack( Deque *d, Entry *e )
+{
+  pthread_mutex_lock( &d->lock );
+  if( d->len == d->cap ){
+    // unroll the ring into a bigger array
+    Entry **items = ( Entry ** )malloc( d->cap * 2 * sizeof( Entry * ) );
+    for( int i = 0; i < d->len; i++ ){
+      items[ i ] = d->items[ ( d->first + i ) % d->cap ];
+    }
+    free( d->items );
+    d->items = items;
+    d->first = 0;
+    d->cap *= 2;
+  }
+
+  d->items[ ( d->first + d->len++ ) % d->cap ] = e;
+  pthread_mutex_unlock( &d->lock );
+}
+
+/**
+ * This function takes a file from one end of a deque.  Owners take the oldest file, so the manifest
+ * keeps moving, and thieves take the newest, so they don't compete with the owner
+ * @param d the deque
+ * @param oldest true to take from the oldest end
+ * @return the file, or NULL if the deque is empty
+*/
+static Entry *take( Deque *d, bool oldest )
+{
+  Entry *e = NULL;
+
+  pthread_mutex_lock( &d->lock );
+  if( d->len > 0 ){
+    if( oldest ){
+      e = d->items[ d->first ];
+      d->first = ( d->first + 1 ) % d->cap;
+    } else {
+      e = d->items[ ( d->first + d->len - 1 ) % d->cap ];
+    }
+    d->len--;
+  }
+  pthread_mutex_unlock( &d->lock );
+
+  return e;
+}
+
+/**
+ * This function finds the next file for a worker, from its own deque or stolen from another one,
+ * waiting for the walk if every deque is empty
+ * @param tree the shared tree
+ * @param id the worker's index
+ * @return the file, or NULL once the walk is over and every file is taken
+*/
+static Entry *nextEntry( Tree *tree, int id )
+{
+  while( 1 ){
+    Entry *e = take( tree->deques + id, true );
+    for( int i = 1; e == NULL && i < tree->workers; i++ ){
+      e = take( tree->deques + ( id + i ) % tree->workers, false );
+    }
+
+    pthread_mutex_lock( &tree->lock );
+    if( e ){
+      tree->queued--;
+      pthread_mutex_unlock( &tree->lock );
+      return e;
+    }
+
+    // a file queued after we looked makes queued non-zero, so we can't miss it
+    while( tree->queued == 0 && !tree->walked ){
+      pthread_cond_wait( &tree->more, &tree->lock );
+    }
+
+    bool over = tree->queued == 0;
+    pthread_mutex_unlock( &tree->lock );
+    if( over ){
+      return NULL;
+    }
+  }
+}
+
+/**
+ * This function is the start routine for each worker thread. It hashes files until there are none left
+ * @param arg the worker
+ * @return NULL
+*/
+static void *worker( void *arg )
+{
+  Worker *w = ( Worker * )arg;
+  Tree *tree = w->tree;
+
+  Entry *e;
+  while( ( e = nextEntry( tree, w->id ) ) ){
+    int err = tree->hasher( e->path, &e->state ) ? 0 : errno;
+
+    pthread_mutex_lock( &tree->lock );
+    e->err = err;
+    e->done = true;
+    pthread_cond_broadcast( &tree->finished );
+    pthread_mutex_unlock( &tree->lock );
+  }
+
+  return NULL;
+}
+
+/**
+ * This function adds a file to the end of the manifest
+ * @param tree the shared tree
+ * @param path path to the file, which the entry takes over
+ * @param size size of the file
+ * @return the new entry
+*/
+static Entry *addEntry( Tree *tree, char *path, off_t size )
+{
+  if( tree->count == tree->cap ){
+    tree->cap *= 2;
+    tree->entries = ( Entry ** )realloc( tree->entries, tree->cap * sizeof( Entry * ) );
+  }
+
+  Entry *e = ( Entry * )calloc( 1, sizeof( Entry ) );
+  e->path = path;
+  e->size = size;
+  tree->entries[ tree->count++ ] = e;
+  return e;
+}
+
+/**
+ * This function records a file or directory that couldn't be read, so the error is reported in its
+ * place in the manifest
+ * @param tree the shared tree
+ * @param path path to the file, which the entry takes over
+ * @param err the errno value for the error
+*/
+static void addError( Tree *tree, char *path, int err )
+{
+  Entry *e = addEntry( tree, path, 0 );
+  e->err = err;
+  e->done = true;
+}
+
+/**
+ * This function prints every entry that's ready, up to the first one that isn't
+ * @param tree the shared tree
+ * @param wait true to wait for every entry instead of stopping at the first one that isn't done
+ * @return true if there were no errors in the entries printed
+*/
+static bool printReady( Tree *tree, bool wait )
+{
+  bool ok = true;
+
+  while( tree->printed < tree->count ){
+    Entry *e = tree->entries[ tree->printed ];
+
+    pthread_mutex_lock( &tree->lock );
+    while( wait && !e->done ){
+      pthread_cond_wait( &tree->finished, &tree->lock );
+    }
+    bool done = e->done;
+    pthread_mutex_unlock( &tree->lock );
+
+    if( !done ){
+      break;
+    }
+
+    if( e->err ){
+      fflush( stdout );
+      fprintf( stderr, "%s: %s\n", e->path, strerror( e->err ) );
+      ok = false;
+    } else {
+      char str[ HASH_CHARS + 1 ];
+      hashString( &e->state, str );
+      printf( "%s  %s\n", str, e->path );
+    }
+
+    tree->printed++;
+  }
+
+  return ok;
+}
+
+/** Something found in a directory, waiting for the directory to be sorted */
+typedef struct {
+  /** Path to it */
+  char *path;
+
+  /** Its metadata, from lstat() */
+  struct stat st;
+
+  /** Zero if lstat() worked, or the errno value saying why it didn't */
+  int err;
+
+  /** True if it's a directory */
+  bool dir;
+} Child;
+
+/**
+ * This function compares the paths of two things in the same directory, byte by byte, so the order
+ * doesn't depend on the locale.  A directory sorts as if its path ended in a slash, which puts it
+ * where the files under it belong in a sorted list of paths, so walking depth first gives a manifest
+ * sorted by path
+ * @param a the first child
+ * @param b the second child
+ * @return negative, zero or positive, like strcmp()
+*/
+static int compareChildren( const void *a, const void *b )
+{
+  Child const *x = ( Child const * )a;
+  Child const *y = ( Child const * )b;
+  char const *p = x->path, *q = y->path;
+  while( *p && *p == *q ){
+    p++;
+    q++;
+  }
+
+  int c = *p ? ( unsigned char )*p : x->dir ? '/' : 0;
+  int d = *q ? ( unsigned char )*q : y->dir ? '/' : 0;
+  return c - d;
+}
+
+/**
+ * This function joins a directory and a name into a new path
+ * @param dir the directory
+ * @param name the name inside it
+ * @return the path, which the caller frees
+*/
+static char *joinPath( char const *dir, char const *name )
+{
+  size_t len = strlen( dir );
+  char *path = ( char * )malloc( len + strlen( name ) + 2 );
+  strcpy( path, dir );
+  if( len == 0 || dir[ len - 1 ] != '/' ){
+    path[ len++ ] = '/';
+  }
+  strcpy( path + len, name );
+  return path;
+}
+
+/**
+ * This function walks a directory in sorted order, queuing every regular file under it and walking
+ * each subdirectory as it comes to it.  Symbolic links and special files are skipped
+ * @param tree the shared tree
+ * @param dir path to the directory
+ * @param ok set to false if anything can't be read
+*/
+static void walkDir( Tree *tree, char const *dir, bool *ok )
+{
+  struct dirent **names;
+  int n = scandir( dir, &names, NULL, NULL );
+  if( n < 0 ){
+    addError( tree, strdup( dir ), errno );
+    return;
+  }
+
+  // directories sort differently from files, so look at everything before sorting
+  Child *kids = ( Child * )malloc( n * sizeof( Child ) );
+  int count = 0;
+  for( int i = 0; i < n; i++ ){
+    char const *name = names[ i ]->d_name;
+    if( strcmp( name, "." ) != 0 && strcmp( name, ".." ) != 0 ){
+      Child *k = kids + count++;
+      k->path = joinPath( dir, name );
+      k->err = lstat( k->path, &k->st ) == 0 ? 0 : errno;
+      k->dir = k->err == 0 && S_ISDIR( k->st.st_mode );
+    }
+    free( names[ i ] );
+  }
+  free( names );
+  qsort( kids, count, sizeof( Child ), compareChildren );
+
+  for( int i = 0; i < count; i++ ){
+    Child *k = kids + i;
+    if( k->err ){
+      addError( tree, k->path, k->err );
+    } else if( k->dir ){
+      walkDir( tree, k->path, ok );
+      free( k->path );
+    } else if( S_ISREG( k->st.st_mode ) ){
+      // deal files out round robin; stealing evens out any imbalance
+      Entry *e = addEntry( tree, k->path, k->st.st_size );
+      pushBack( tree->deques + ( tree->count % tree->workers ), e );
+
+      pthread_mutex_lock( &tree->lock );
+      tree->queued++;
+      pthread_cond_signal( &tree->more );
+      pthread_mutex_unlock( &tree->lock );
+    } else {
+      free( k->path );
+    }
+  }
+  free( kids );
+
+  // print what's finished so far, so the manifest starts before the walk is over
+  if( !printReady( tree, false ) ){
+    *ok = false;
+  }
+}
+
+/**
+ * This function gives the current time, for throughput reports
+ * @return seconds from some fixed point in the past
+*/
+static double now()
+{
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return ts.tv_sec + ts.tv_nsec / 1.0e9;
+}
+
+/**
+ * This function hashes every regular file under each of the given directories, and prints a manifest
+ * with a "digest  path" line for each file, sorted by path.  Files that can't be read are reported on
+ * standard error in their place.  Once every file is done, the throughput is reported on standard
+ * error, in MB/s and files/s
+ * @param dirs the directories to hash
+ * @param count the number of directories
+ * @param hasher function that hashes each file, like hashFile()
+ * @return program exit status
+*/
+int hashTree( char **dirs, int count, FileHasher hasher )
+{
+  double start = now();
+
+  Tree tree;
+  tree.count = 0;
+  tree.cap = ENTRY_CAPACITY;
+  tree.entries = ( Entry ** )malloc( tree.cap * sizeof( Entry * ) );
+  tree.printed = 0;
+  tree.queued = 0;
+  tree.walked = false;
+  tree.hasher = hasher;
+  pthread_mutex_init( &tree.lock, NULL );
+  pthread_cond_init( &tree.more, NULL );
+  pthread_cond_init( &tree.finished, NULL );
+
+  // one worker for each core, each with its own deque
+  long cores = sysconf( _SC_NPROCESSORS_ONLN );
+  tree.workers = cores < 1 ? 1 : cores;
+  tree.deques = ( Deque * )malloc( tree.workers * sizeof( Deque ) );
+  Worker *workers = ( Worker * )malloc( tree.workers * sizeof( Worker ) );
+  pthread_t *threads = ( pthread_t * )malloc( tree.workers * sizeof( pthread_t ) );
+  for( int i = 0; i < tree.workers; i++ ){
+    Deque *d = tree.deques + i;
+    d->cap = DEQUE_CAPACITY;
+    d->items = ( Entry ** )malloc( d->cap * sizeof( Entry * ) );
+    d->first = 0;
+    d->len = 0;
+    pthread_mutex_init( &d->lock, NULL );
+  }
+
+  for( int i = 0; i < tree.workers; i++ ){
+    workers[ i ].tree = &tree;
+    workers[ i ].id = i;
+    if( pthread_create( threads + i, NULL, worker, workers + i ) != 0 ){
+      fprintf( stderr, "Can't create thread\n" );
+      exit( EXIT_FAILURE );
+    }
+  }
+
+  // walk the trees while the workers hash
+  bool ok = true;
+  for( int i = 0; i < count; i++ ){
+    walkDir( &tree, dirs[ i ], &ok );
+  }
+
+  pthread_mutex_lock( &tree.lock );
+  tree.walked = true;
+  pthread_cond_broadcast( &tree.more );
+  pthread_mutex_unlock( &tree.lock );
+
+  if( !printReady( &tree, true ) ){
+    ok = false;
+  }
+  fflush( stdout );
+
+  for( int i = 0; i < tree.workers; i++ ){
+    pthread_join( threads[ i ], NULL );
+  }
+
+  // report throughput for the files that were hashed
+  int files = 0;
+  double bytes = 0;
+  for( int i = 0; i < tree.count; i++ ){
+    Entry *e = tree.entries[ i ];
+    if( !e->err ){
+      files++;
+      bytes += e->size;
+    }
+    free( e->path );
+    free( e );
+  }
+
+  double secs = now() - start;
+  if( secs <= 0 ){
+    secs = 1.0e-9;
+  }
+  fprintf( stderr, "hashed %d files, %.1f MB in %.3f s: %.1f MB/s, %.0f files/s\n", files,
+           bytes / MEGABYTE, secs, bytes / MEGABYTE / secs, files / secs );
+
+  for( int i = 0; i < tree.workers; i++ ){
+    free( tree.deques[ i ].items );
+    pthread_mutex_destroy( &tree.deques[ i ].lock );
+  }
+  pthread_cond_destroy( &tree.finished );
+  pthread_cond_destroy( &tree.more );
+  pthread_mutex_destroy( &tree.lock );
+  free( threads );
+  free( workers );
+  free( tree.deques );
+  free( tree.entries );
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,27 @@
+/**
+ * @file treeHash.h
+ * @author Jake Donovan (jmpatte8)
+ * This header file is for hashing every regular file under a directory.  The tree is walked while
+ * worker threads hash the files it finds, and a manifest of "digest  path" lines is printed in path
+ * order as the hashes come in.
+*/
+
+#ifndef _TREE_HASH_H_
+/** Our directory hashing header */
+#define _TREE_HASH_H_
+
+#include "fileHash.h"
+
+/** Initial number of files each worker's deque can hold */
+#define DEQUE_CAPACITY 64
+
+/** Initial number of files the manifest can hold */
+#define ENTRY_CAPACITY 256
+
+/** Bytes in a megabyte, for throughput reports */
+#define MEGABYTE 1.0e6
+
+/** hashTree function prototype */
+int hashTree( char **dirs, int count, FileHasher hasher );
+
+#endif
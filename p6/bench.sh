@@ -0,0 +1,48 @@
+#!/bin/bash
+# Time each build of the interpreter on the test program corpus and on
+# the bench-*.txt programs.  The corpus programs are tiny, so they're run
+# many times over in one batch to get a measurable time.
+#
+# usage: ./bench.sh [corpus-repeat-count]
+
+REPEAT=${1:-200}
+
+# Each engine to compare, as a label and the command that runs it.
+ENGINES=( "tree:./interpret"
+          "flat:./interpret-flat"
+          "jit:./interpret-jit" )
+
+make interpret interpret-flat interpret-jit > /dev/null || exit 1
+
+# Build the batch list for the corpus, all the tests that run successfully.
+LIST=corpus-list.txt
+rm -f $LIST
+for (( i = 0; i < REPEAT; i++ )); do
+    for t in 01 02 03 04 05 06 07 08 09 10 11 12 13 14 15; do
+        echo prog-$t.txt >> $LIST
+    done
+done
+
+# Print the time, in seconds, for running the given command.
+timeRun() {
+    TIMEFORMAT=%R
+    { time "$@" > /dev/null 2>&1; } 2>&1
+}
+
+printf "%-10s %10s" engine corpus
+for b in bench-*.txt; do
+    printf " %10s" ${b%.txt}
+done
+echo
+
+for e in "${ENGINES[@]}"; do
+    NAME=${e%%:*}
+    CMD=${e#*:}
+    printf "%-10s %10s" $NAME $( timeRun $CMD --batch $LIST )
+    for b in bench-*.txt; do
+        printf " %10s" $( timeRun $CMD $b )
+    done
+    echo
+done
+
+rm -f $LIST
@@ -0,0 +1,106 @@
+#!/bin/bash
+# Differential test for the execution engines.  Generates random programs
+# with progGen, runs every one of them through each engine and through
+# batch mode, and checks that stdout, stderr and the exit status all
+# match the reference tree-walking interpreter.  It also reports the
+# throughput of each mode, so it doubles as a performance check.
+#
+# usage: ./difftest.sh [program-count] [first-seed]
+
+COUNT=${1:-200}
+SEED=${2:-1}
+
+# Engines that run one program per process, as a label and a command.
+# The first one is the reference the others are checked against.
+ENGINES=( "tree:./interpret --no-opt"
+          "opt:./interpret"
+          "flat:./interpret-flat"
+          "jit:./interpret-jit --jit-threshold 1" )
+
+# Ways of running the whole list of programs in one process.
+BATCHES=( "batch:./interpret --batch"
+          "batch-j4:./interpret -j 4 --batch"
+          "slice-j2:./interpret -j 2 --slice 5 --batch" )
+
+make interpret interpret-flat interpret-jit progGen > /dev/null || exit 1
+
+DIR=$( mktemp -d )
+trap 'rm -rf $DIR' EXIT
+
+for (( i = 0; i < COUNT; i++ )); do
+    ./progGen $(( SEED + i )) > $DIR/prog-$i.txt
+    echo $DIR/prog-$i.txt >> $DIR/list.txt
+done
+
+FAIL=0
+REF=${ENGINES[0]%%:*}
+
+# Print elapsed seconds and programs per second, given start and end
+# times in nanoseconds.
+throughput() {
+    awk -v ns=$(( $2 - $1 )) -v n=$COUNT \
+        'BEGIN { printf "%10.3f %12.1f\n", ns / 1e9, n / ( ns / 1e9 ) }'
+}
+
+printf "%-10s %10s %12s\n" mode seconds programs/s
+
+for e in "${ENGINES[@]}"; do
+    NAME=${e%%:*}
+    CMD=${e#*:}
+
+    START=$( date +%s%N )
+    for (( i = 0; i < COUNT; i++ )); do
+        $CMD $DIR/prog-$i.txt > $DIR/$NAME-$i.out 2> $DIR/$NAME-$i.err
+        echo $? > $DIR/$NAME-$i.status
+    done
+    END=$( date +%s%N )
+    printf "%-10s %s\n" $NAME "$( throughput $START $END )"
+
+    if [ $NAME != $REF ]; then
+        for (( i = 0; i < COUNT; i++ )); do
+            for f in out err status; do
+                if ! cmp -s $DIR/$REF-$i.$f $DIR/$NAME-$i.$f; then
+                    echo "**** $NAME differs from $REF ($f) for progGen $(( SEED + i ))"
+                    FAIL=1
+                fi
+            done
+        done
+    fi
+done
+
+# Expected results for a batch are the reference results, concatenated.
+STATUS=0
+for (( i = 0; i < COUNT; i++ )); do
+    cat $DIR/$REF-$i.out >> $DIR/expected.out
+    cat $DIR/$REF-$i.err >> $DIR/expected.err
+    if [ $( cat $DIR/$REF-$i.status ) -ne 0 ]; then
+        STATUS=1
+    fi
+done
+echo $STATUS > $DIR/expected.status
+
+for b in "${BATCHES[@]}"; do
+    NAME=${b%%:*}
+    CMD=${b#*:}
+
+    START=$( date +%s%N )
+    $CMD $DIR/list.txt > $DIR/$NAME.out 2> $DIR/$NAME.err
+    echo $? > $DIR/$NAME.status
+    END=$( date +%s%N )
+    printf "%-10s %s\n" $NAME "$( throughput $START $END )"
+
+    for f in out err status; do
+        if ! cmp -s $DIR/expected.$f $DIR/$NAME.$f; then
+            echo "**** $NAME differs from $REF ($f)"
+            FAIL=1
+        fi
+    done
+done
+
+if [ $FAIL -ne 0 ]; then
+    echo "ENGINES DISAGREE!"
+    exit 13
+fi
+
+echo "All engines agree on $COUNT programs"
+exit 0
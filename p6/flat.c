@@ -0,0 +1,359 @@
+/**
+ * @file flat.c
+ * @author Jake Donovan (jmpatte8)
+ * Flattens expression trees into arrays of instructions in post-order and evaluates them with a dispatch
+ * loop built on computed gotos, as an alternative to calling the eval function in every node
+*/
+
+#include "flat.h"
+#include "optimize.h"
+#include <stdlib.h>
+
+/** Initial capacity for the instruction array in a flattened expression. */
+#define INITIAL_CAPACITY 5
+
+/** Operations in a flattened expression.  The order here has to match the
+    table of labels in evalFlat(). */
+typedef enum { OpLiteral, OpVariable, OpAdd, OpSub, OpMul, OpDiv, OpLess,
+               OpEquals, OpLen, OpCheckSeq, OpIndex, OpCheckInt, OpSeqInit,
+               OpAnd, OpOr, OpSort, OpFind, OpEval, OpEnd } Op;
+
+/** One instruction in a flattened expression. */
+typedef struct {
+  /** Operation to perform. */
+  Op op;
+
+  /** Value for OpLiteral, cached environment slot for OpVariable, element
+      count for OpSeqInit and jump target for OpAnd and OpOr. */
+  int arg;
+
+  union {
+    /** Variable name for OpVariable, pointing into the original tree. */
+    char const *name;
+
+    /** Expression to evaluate the usual way, for OpEval. */
+    Expr *expr;
+  };
+} Instr;
+
+/** Representation for a flattened expression, a subclass of Expr. */
+typedef struct {
+  Value (*eval)( Expr *expr, Environment *env );
+  void (*destroy)( Expr *expr );
+
+  /** Original expression tree, kept so we can free it. */
+  Expr *tree;
+
+  /** Resizable array of instructions, in the order they run. */
+  Instr *code;
+
+  /** Number of instructions. */
+  int len;
+
+  /** Capacity of the instruction array. */
+  int cap;
+
+  /** Number of values on the stack right now, while we're compiling. */
+  int height;
+
+  /** Largest number of values evaluation will ever need on the stack. */
+  int depth;
+} FlatExpr;
+
+/**
+ * Add an instruction to the end of a flattened expression
+ * @param this the expression we're building
+ * @param op operation for the new instruction
+ * @param arg integer argument for the new instruction
+ * @param push change in the stack height after this instruction runs
+ * @return index of the new instruction, so jump targets can be filled in later
+*/
+static int emit( FlatExpr *this, Op op, int arg, int push )
+{
+  if ( this->len >= this->cap ) {
+    this->cap *= 2;
+    this->code = (Instr *) realloc( this->code, this->cap * sizeof( Instr ) );
+  }
+
+  this->code[ this->len ] = (Instr){ op, arg };
+
+  this->height += push;
+  if ( this->height > this->depth )
+    this->depth = this->height;
+
+  return this->len++;
+}
+
+/**
+ * Append post-order code for the given expression tree
+ * @param this the expression we're building
+ * @param expr the (sub)expression to compile
+*/
+static void compile( FlatExpr *this, Expr *expr )
+{
+  ExprKind kind = exprKind( expr );
+  int pos;
+
+  switch ( kind ) {
+  case LiteralKind:
+    emit( this, OpLiteral, literalValue( expr ), 1 );
+    break;
+
+  case VariableKind:
+    pos = emit( this, OpVariable, 0, 1 );
+    this->code[ pos ].name = variableName( expr );
+    break;
+
+  case AddKind:
+  case SubKind:
+  case MulKind:
+  case DivKind:
+  case LessKind:
+  case EqualsKind:
+    compile( this, *exprChild( expr, 0 ) );
+    compile( this, *exprChild( expr, 1 ) );
+    emit( this, kind == AddKind ? OpAdd : kind == SubKind ? OpSub :
+          kind == MulKind ? OpMul : kind == DivKind ? OpDiv :
+          kind == LessKind ? OpLess : OpEquals, 0, -1 );
+    break;
+
+  case LenKind:
+    compile( this, *exprChild( expr, 0 ) );
+    emit( this, OpLen, 0, 0 );
+    break;
+
+  case SortKind:
+    compile( this, *exprChild( expr, 0 ) );
+    emit( this, OpSort, 0, 0 );
+    break;
+
+  case FindKind:
+    compile( this, *exprChild( expr, 0 ) );
+    compile( this, *exprChild( expr, 1 ) );
+    emit( this, OpFind, 0, -1 );
+    break;
+
+  case IndexKind:
+    // The sequence gets checked before the index is evaluated.
+    compile( this, *exprChild( expr, 0 ) );
+    emit( this, OpCheckSeq, 0, 0 );
+    compile( this, *exprChild( expr, 1 ) );
+    emit( this, OpIndex, 0, -1 );
+    break;
+
+  case SeqInitKind: {
+    // Each element is checked as soon as it's evaluated.
+    int n = exprCount( expr );
+    for ( int i = 0; i < n; i++ ) {
+      compile( this, *exprChild( expr, i ) );
+      emit( this, OpCheckInt, 0, 0 );
+    }
+    emit( this, OpSeqInit, n, 1 - n );
+    break;
+  }
+
+  case AndKind:
+  case OrKind:
+    // Short-circuit by jumping past the right operand, leaving the
+    // left-hand value on the stack as the result.
+    compile( this, *exprChild( expr, 0 ) );
+    pos = emit( this, kind == AndKind ? OpAnd : OpOr, 0, -1 );
+    compile( this, *exprChild( expr, 1 ) );
+    emit( this, OpCheckInt, 0, 0 );
+    this->code[ pos ].arg = this->len;
+    break;
+
+  default: {
+    // Some other kind of expression, just evaluate it the usual way.  If
+    // the optimizer wrapped an expression, the inside can still be flat.
+    Expr **inner = optimizedExpr( expr );
+    if ( inner )
+      *inner = flattenExpr( *inner );
+
+    pos = emit( this, OpEval, 0, 1 );
+    this->code[ pos ].expr = expr;
+    break;
+  }
+  }
+}
+
+/** Implementation of eval for a flattened expression */
+static Value evalFlat( Expr *expr, Environment *env )
+{
+  FlatExpr *this = (FlatExpr *)expr;
+
+  // Address of the code for each operation, in the same order as Op.
+  static void *label[] = { &&literal, &&variable, &&add, &&sub, &&mul, &&div,
+                           &&less, &&equals, &&len, &&checkSeq, &&index,
+                           &&checkInt, &&seqInit, &&and, &&or, &&sort,
+                           &&find, &&eval, &&end };
+
+  // Stack of intermediate values, sp points to the next free element.
+  Value stack[ this->depth ];
+  Value *sp = stack;
+
+  // Start running at the first instruction, then go right to the next
+  // instruction at the end of each one.
+  Instr *ip = this->code;
+  goto *label[ ip->op ];
+#define NEXT goto *label[ ( ++ip )->op ]
+
+ literal:
+  *sp++ = (Value){ IntType, .ival = ip->arg };
+  NEXT;
+
+ variable:
+  *sp++ = lookupCached( env, ip->name, &ip->arg );
+  NEXT;
+
+ add:
+  sp--;
+  requireIntType( sp - 1 );
+  requireIntType( sp );
+  sp[ -1 ].ival += sp->ival;
+  NEXT;
+
+ sub:
+  sp--;
+  requireIntType( sp - 1 );
+  requireIntType( sp );
+  sp[ -1 ].ival -= sp->ival;
+  NEXT;
+
+ mul:
+  sp--;
+  requireIntType( sp - 1 );
+  requireIntType( sp );
+  sp[ -1 ].ival *= sp->ival;
+  NEXT;
+
+ div:
+  sp--;
+  sp[ -1 ] = applyDiv( sp[ -1 ], *sp );
+  NEXT;
+
+ less:
+  sp--;
+  if ( sp[ -1 ].vtype == IntType && sp->vtype == IntType )
+    sp[ -1 ].ival = sp[ -1 ].ival < sp->ival;
+  else
+    sp[ -1 ] = applyLess( sp[ -1 ], *sp );
+  NEXT;
+
+ equals:
+  sp--;
+  if ( sp[ -1 ].vtype == IntType && sp->vtype == IntType )
+    sp[ -1 ].ival = sp[ -1 ].ival == sp->ival;
+  else
+    sp[ -1 ] = applyEquals( sp[ -1 ], *sp );
+  NEXT;
+
+ len:
+  sp[ -1 ] = applyLen( sp[ -1 ] );
+  NEXT;
+
+ checkSeq:
+  requireSequence( sp - 1 );
+  NEXT;
+
+ index:
+  sp--;
+  sp[ -1 ] = applyIndex( sp[ -1 ], *sp );
+  NEXT;
+
+ checkInt:
+  requireIntType( sp - 1 );
+  NEXT;
+
+ sort:
+  sp[ -1 ] = applySort( sp[ -1 ] );
+  NEXT;
+
+ find:
+  sp--;
+  sp[ -1 ] = applyFind( sp[ -1 ], *sp );
+  NEXT;
+
+ seqInit: {
+    Sequence *seq = makeSequence();
+    sp -= ip->arg;
+    for ( int i = 0; i < ip->arg; i++ )
+      seqPush( seq, sp[ i ].ival );
+    *sp++ = (Value){ SeqType, .sval = seq };
+  }
+  NEXT;
+
+ and:
+  requireIntType( sp - 1 );
+  if ( sp[ -1 ].ival == 0 ) {
+    ip = this->code + ip->arg;
+    goto *label[ ip->op ];
+  }
+  sp--;
+  NEXT;
+
+ or:
+  requireIntType( sp - 1 );
+  if ( sp[ -1 ].ival ) {
+    ip = this->code + ip->arg;
+    goto *label[ ip->op ];
+  }
+  sp--;
+  NEXT;
+
+ eval:
+  *sp++ = ip->expr->eval( ip->expr, env );
+  NEXT;
+
+ end:
+  return sp[ -1 ];
+#undef NEXT
+}
+
+/** Implementation of destroy for a flattened expression */
+static void destroyFlat( Expr *expr )
+{
+  FlatExpr *this = (FlatExpr *)expr;
+
+  this->tree->destroy( this->tree );
+  free( this->code );
+  free( this );
+}
+
+/** Documented in the header. */
+Expr *flattenExpr( Expr *expr )
+{
+  FlatExpr *this = (FlatExpr *) malloc( sizeof( FlatExpr ) );
+  this->eval = evalFlat;
+  this->destroy = destroyFlat;
+  this->tree = expr;
+
+  this->len = 0;
+  this->cap = INITIAL_CAPACITY;
+  this->code = (Instr *) malloc( this->cap * sizeof( Instr ) );
+  this->height = 0;
+  this->depth = 0;
+
+  compile( this, expr );
+  emit( this, OpEnd, 0, 0 );
+
+  return (Expr *) this;
+}
+
+/** Documented in the header. */
+Expr *flatTree( Expr *expr )
+{
+  return expr->eval == evalFlat ? ((FlatExpr *)expr)->tree : NULL;
+}
+
+/** Documented in the header. */
+void flattenStmt( Stmt *stmt )
+{
+  for ( int i = 0; i < stmtExprCount( stmt ); i++ ) {
+    Expr **slot = stmtExpr( stmt, i );
+    *slot = flattenExpr( *slot );
+  }
+
+  for ( int i = 0; i < stmtBodyCount( stmt ); i++ )
+    flattenStmt( *stmtBody( stmt, i ) );
+}
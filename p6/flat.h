@@ -0,0 +1,39 @@
+/**
+  @file flat.h
+  @author Jake Donovan (jmpatte8)
+
+  An alternative engine for evaluating expressions.  Rather than calling
+  through the eval pointer in every node of an expression tree, the tree
+  is flattened into an array of tagged instructions in post-order and
+  run by a single dispatch loop using GCC's computed gotos.  Variable
+  lookups in the flattened code keep an inline cache of where the
+  variable was last found in the environment.
+*/
+
+#ifndef _FLAT_H_
+#define _FLAT_H_
+
+#include "syntax.h"
+
+/** Make a flattened version of the given expression.  The new expression
+    takes ownership of the tree it was made from and evaluates to
+    exactly the same values, with the same errors.
+    @param expr expression tree to flatten.
+    @return a new expression that runs the flattened code.
+ */
+Expr *flattenExpr( Expr *expr );
+
+/** Return the expression tree a flattened expression was made from, so
+    other passes can still see its structure.
+    @param expr expression to check.
+    @return the original tree, or NULL if expr isn't a flattened expression.
+ */
+Expr *flatTree( Expr *expr );
+
+/** Replace every expression used in the given statement, and in the
+    statements nested inside it, with a flattened version.
+    @param stmt statement to flatten.
+ */
+void flattenStmt( Stmt *stmt );
+
+#endif
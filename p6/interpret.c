@@ -2,63 +2,889 @@
  * @file interpret.c
  * @author Jake Donovan
  * This file is responsible for running all included files in this program to correctly parse and perform each stmt and conditional specified in the passed
- * file
+ * file.  In batch mode, it runs a whole list of program files in the same process, optionally spread across several worker threads.
+ * With time slicing, every program in the batch runs at once, taking turns on the worker threads.
+ * In REPL mode, statements are read from standard input and run one at a time as they're typed.
 */
 
+#define _DEFAULT_SOURCE
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <errno.h>
+#include <setjmp.h>
+#include <pthread.h>
+#include <ucontext.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include "value.h"
 #include "syntax.h"
 #include "parse.h"
+#include "runtime.h"
+#include "optimize.h"
+#include "pool.h"
+#include "trace.h"
+
+#ifdef FLAT_EVAL
+#include "flat.h"
+#endif
+
+#ifdef JIT_EVAL
+#include "jit.h"
+#endif
+
+/** Largest number of worker threads we'll start for a batch. */
+#define MAX_WORKERS 64
+
+/** Initial capacity for the list of programs in a batch. */
+#define INITIAL_CAPACITY 5
+
+/** Size of the stack for each program run with time slicing, the same
+    as the default stack for a thread. */
+#define PROGRAM_STACK ( 8 * 1024 * 1024 )
+
+/** True if statements should be optimized before they run. */
+static bool optimize = true;
+
+/** Statements each program can execute, or zero for no limit. */
+static unsigned long budget = 0;
+
+/** Statements in each time slice in batch mode, or zero to run each
+    program to the end before starting another. */
+static unsigned long slice = 0;
 
 /** Print a usage message then exit unsuccessfully. */
 void usage()
 {
   fprintf( stderr, "usage: interpret <program-file>\n" );
+  fprintf( stderr, "       interpret --batch <list-file|-> [-j <workers>] [--slice <statements>]\n" );
+  fprintf( stderr, "       interpret --repl\n" );
+  fprintf( stderr, "       options: --no-opt, --pool-stats, --budget <statements>, --sched-stats\n" );
+  fprintf( stderr, "       options: --trace, --trace-file <file>\n" );
+#ifdef JIT_EVAL
+  fprintf( stderr, "       options: --no-jit, --jit-threshold <iterations>\n" );
+#endif
   exit( EXIT_FAILURE );
 }
 
+/** A whole parsed program, along with how far we've gotten running it. */
+typedef struct {
+  /** Resizable array of top-level statements.  Statements are freed as
+      soon as they've run, leaving NULL behind. */
+  Stmt **list;
+  /** Number of statements. */
+  int len;
+  /** Capacity of the list. */
+  int cap;
+
+  /** Index of the next statement to run. */
+  int next;
+} Program;
+
 /**
- * Program starting point, calls all files to parse a file and correctly perform all specified statements and operations
- * @param argc the number of command line arguments
- * @param argv an array of char pointers which point to each command line argument
- * @return program exit status
+ * Open a stream that collects everything written to it in a growing buffer in memory.  There's no
+ * good way to carry on without one, so this exits if the stream can't be opened
+ * @param buf set to the buffer, once the stream is flushed or closed
+ * @param len set to the length of the buffer
+ * @return the new stream
 */
-int main( int argc, char *argv[] )
+static FILE *captureStream( char **buf, size_t *len )
 {
-  // Open the program's source.
-  if ( argc != 2 )
-    usage();
-  
-  FILE *fp = fopen( argv[ 1 ], "r" );
+  FILE *fp = open_memstream( buf, len );
   if ( !fp ) {
-    perror( argv[ 1 ] );
+    perror( "open_memstream" );
     exit( EXIT_FAILURE );
   }
 
-  // Environment, for storing variable values.
-  Environment *env = makeEnvironment();
-  
-  // Parse one statement at a time, then run each statement
-  // using the same Environment.
+  return fp;
+}
+
+/**
+ * Parse every statement in a program, stopping at the first syntax error
+ * @param fp the file we are reading the program from
+ * @param prog program to add the statements to
+ * @return true if the whole program parsed without an error
+*/
+static bool parseProgram( FILE *fp, Program *prog )
+{
+  jmp_buf recover;
+  if ( setjmp( recover ) ) {
+    // Partly parsed statements can't be recovered, so a syntax error leaks
+    // those.
+    setRecoveryPoint( NULL );
+    return false;
+  }
+  setRecoveryPoint( &recover );
+
   char tok[ MAX_TOKEN + 1 ];
   while ( parseToken( tok, fp ) ) {
-    // Parse the next input statement.
     Stmt *stmt = parseStmt( tok, fp );
 
+    if ( prog->len >= prog->cap ) {
+      prog->cap *= 2;
+      prog->list = (Stmt **) realloc( prog->list, prog->cap * sizeof( Stmt * ) );
+    }
+    prog->list[ prog->len++ ] = stmt;
+  }
+
+  setRecoveryPoint( NULL );
+  return true;
+}
+
+/**
+ * Run the statements of a program in order, using the given environment, freeing each one once
+ * it's done
+ * @param prog the program to run
+ * @param env environment for storing variable values
+ * @return true if every statement ran without an error
+*/
+static bool runStatements( Program *prog, Environment *env )
+{
+  jmp_buf recover;
+  if ( setjmp( recover ) ) {
+    setRecoveryPoint( NULL );
+    return false;
+  }
+  setRecoveryPoint( &recover );
+
+  while ( prog->next < prog->len ) {
+    Stmt *stmt = prog->list[ prog->next ];
+
+    // Hoist loop-invariant expressions out of its loops.
+    if ( optimize )
+      hoistInvariants( stmt );
+
+#ifdef FLAT_EVAL
+    // Switch the statement over to the computed-goto expression engine.
+    flattenStmt( stmt );
+#endif
+
+#ifdef JIT_EVAL
+    // Let hot loops in the statement get compiled.
+    stmt = jitStmt( stmt );
+#endif
+
+    // Keep the list up to date, so the statement gets freed on an error.
+    prog->list[ prog->next ] = stmt;
+
     // Run the statement.
     stmt->execute( stmt, env );
 
     // Delete the statement.
     stmt->destroy( stmt );
+    prog->list[ prog->next++ ] = NULL;
   }
-  
-  // We're done, close the input file and free the environment.
+
+  setRecoveryPoint( NULL );
+  return true;
+}
+
+/**
+ * Parse and run a whole program using the given environment.  An error in the program stops just this
+ * program, not the whole process.  The program is parsed completely before it runs, so dead variables
+ * can be released early, but a syntax error is still reported only after everything before it has run.
+ * @param fp the file we are reading the program from
+ * @param env environment for storing variable values
+ * @return true if the program ran to the end without an error
+*/
+static bool runProgram( FILE *fp, Environment *env )
+{
+  resetParser();
+  setStatementBudget( budget );
+
+  // Start a fresh trace, so an error dump only shows this program.
+  traceRing.count = 0;
+
+  Program prog = { NULL, 0, INITIAL_CAPACITY, 0 };
+  prog.list = (Stmt **) malloc( prog.cap * sizeof( Stmt * ) );
+
+  // Hold on to any syntax error message until it's time to report it.
+  FILE *out = programOutput();
+  FILE *err = programErrors();
+  char *msg = NULL;
+  size_t msgLen = 0;
+  FILE *held = captureStream( &msg, &msgLen );
+  setProgramStreams( out, held );
+  bool parsed = parseProgram( fp, &prog );
+  setProgramStreams( out, err );
+  fclose( held );
+
+  // Release sequences once the variables holding them are dead.
+  if ( optimize )
+    prog.list = releaseDeadVariables( prog.list, prog.len, &prog.len );
+
+  bool ok = runStatements( &prog, env );
+  if ( ok && !parsed ) {
+    fwrite( msg, 1, msgLen, err );
+    ok = false;
+  }
+
+  // Free anything left over after an error.
+  for ( int i = prog.next; i < prog.len; i++ )
+    if ( prog.list[ i ] )
+      prog.list[ i ]->destroy( prog.list[ i ] );
+  free( prog.list );
+  free( msg );
+
+  return ok;
+}
+
+/**
+ * Open and run the program in the given file, reporting an error if it can't be opened
+ * @param path name of the program file
+ * @param env environment for storing variable values
+ * @return true if the program ran to the end without an error
+*/
+static bool runFile( char const *path, Environment *env )
+{
+  FILE *fp = fopen( path, "r" );
+  if ( !fp ) {
+    fprintf( programErrors(), "%s: %s\n", path, strerror( errno ) );
+    return false;
+  }
+
+  bool ok = runProgram( fp, env );
   fclose( fp );
+  return ok;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Batch mode
+
+/** One program in a batch, along with the output it produced. */
+typedef struct {
+  /** Name of the program file. */
+  char *path;
+
+  /** Output from the program, captured by the worker that ran it. */
+  char *out;
+  /** Length of the captured output. */
+  size_t outLen;
+
+  /** Error messages from the program. */
+  char *err;
+  /** Length of the captured error messages. */
+  size_t errLen;
+
+  /** True if the program ran without an error. */
+  bool ok;
+
+  /** True once a worker has finished with this program. */
+  bool done;
+
+  /** With time slicing, the program's own stack, or NULL if it hasn't
+      started yet. */
+  void *stack;
+  /** Where the program left off at the end of its last time slice. */
+  ucontext_t context;
+  /** True once the program has run to the end. */
+  bool finished;
+
+  /** When the program last went on the run queue. */
+  struct timespec queued;
+  /** Longest the program has waited on the run queue, in seconds. */
+  double maxWait;
+  /** Number of time slices the program has had. */
+  long slices;
+} Job;
+
+/** List of programs shared by all the workers in a batch. */
+typedef struct {
+  /** Resizable array of programs to run. */
+  Job *list;
+  /** Number of programs in the list. */
+  int len;
+  /** Capacity of the list. */
+  int cap;
+
+  /** Index of the next program a worker should pick up. */
+  int next;
+
+  /** With time slicing, a circular run queue of indices into list, for
+      programs waiting for their next slice. */
+  int *queue;
+  /** Index in queue of the first waiting program. */
+  int head;
+  /** Number of programs waiting in the queue. */
+  int queued;
+  /** Number of programs that haven't finished yet. */
+  int unfinished;
+
+  /** Lock protecting next, the done flags and the run queue. */
+  pthread_mutex_t lock;
+  /** Signalled whenever a worker finishes a program. */
+  pthread_cond_t finished;
+  /** Signalled when a program goes on the run queue, or the last one
+      finishes. */
+  pthread_cond_t runnable;
+} Batch;
+
+/**
+ * Read the next program name from a batch list, skipping blank lines
+ * @param fp list of program files, one per line
+ * @param line buffer for the line, resized by getline() as needed
+ * @param cap capacity of the line buffer
+ * @return the program name (inside line), or NULL at the end of the list
+*/
+static char *nextPath( FILE *fp, char **line, size_t *cap )
+{
+  while ( getline( line, cap, fp ) != -1 ) {
+    // Trim whitespace from both ends of the line.
+    char *path = *line;
+    while ( isspace( *path ) )
+      path++;
+
+    int len = strlen( path );
+    while ( len > 0 && isspace( path[ len - 1 ] ) )
+      path[ --len ] = '\0';
+
+    if ( len > 0 )
+      return path;
+  }
+
+  return NULL;
+}
+
+/**
+ * Start routine for a worker thread.  It repeatedly takes the next program from the batch and runs it
+ * with its own environment, which is cleared and reused for every program.
+ * @param arg pointer to the shared Batch
+ * @return NULL
+*/
+static void *batchWorker( void *arg )
+{
+  Batch *batch = (Batch *) arg;
+  Environment *env = makeEnvironment();
+  traceThreadStart();
+
+  while ( true ) {
+    pthread_mutex_lock( &batch->lock );
+    if ( batch->next >= batch->len ) {
+      pthread_mutex_unlock( &batch->lock );
+      break;
+    }
+    Job *job = batch->list + batch->next++;
+    pthread_mutex_unlock( &batch->lock );
+
+    // Capture everything the program writes, so it can be printed in order.
+    FILE *out = captureStream( &job->out, &job->outLen );
+    FILE *err = captureStream( &job->err, &job->errLen );
+    setProgramStreams( out, err );
+    traceRing.count = 0;
+
+    job->ok = runFile( job->path, env );
+
+    setProgramStreams( NULL, NULL );
+    fclose( out );
+    fclose( err );
+    clearEnvironment( env );
+
+    pthread_mutex_lock( &batch->lock );
+    job->done = true;
+    pthread_cond_broadcast( &batch->finished );
+    pthread_mutex_unlock( &batch->lock );
+  }
+
+  freeEnvironment( env );
+  traceThreadEnd();
+  poolFlush();
+  return NULL;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Time slicing
+
+/** Program this worker thread is running right now. */
+static __thread Job *runningJob;
+
+/** Context to switch back to when the running program's time slice is
+    over. */
+static __thread ucontext_t *workerContext;
+
+/**
+ * Return the program this thread is running.  This and currentWorker() aren't inlined, since a
+ * program can move to a different thread while it's paused, and that thread's variables have to be
+ * looked up fresh
+ * @return the running program
+*/
+static __attribute__(( noinline )) Job *currentJob()
+{
+  return runningJob;
+}
+
+/**
+ * Return the context of the worker thread running the current program
+ * @return the worker's context
+*/
+static __attribute__(( noinline )) ucontext_t *currentWorker()
+{
+  return workerContext;
+}
+
+/**
+ * Yield function for time slicing.  Saves where the running program is and switches back to its
+ * worker, which puts the program at the back of the run queue.
+*/
+static void yieldToWorker()
+{
+  swapcontext( &currentJob()->context, currentWorker() );
+}
+
+/**
+ * Starting point for a program run with time slicing, on the program's own stack.  It runs the whole
+ * program with a new environment, then switches back to whichever worker is running it at the end.
+*/
+static void sliceMain()
+{
+  Job *job = currentJob();
+
+  FILE *out = captureStream( &job->out, &job->outLen );
+  FILE *err = captureStream( &job->err, &job->errLen );
+  setProgramStreams( out, err );
+
+  Environment *env = makeEnvironment();
+  job->ok = runFile( job->path, env );
   freeEnvironment( env );
 
-  return EXIT_SUCCESS;
+  setProgramStreams( NULL, NULL );
+  fclose( out );
+  fclose( err );
+
+  job->finished = true;
+  setcontext( currentWorker() );
+}
+
+/**
+ * Give a program its own stack and get it ready to start running at sliceMain()
+ * @param job the program to start
+*/
+static void startJob( Job *job )
+{
+  job->stack = mmap( NULL, PROGRAM_STACK, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0 );
+  if ( job->stack == MAP_FAILED ) {
+    perror( "mmap" );
+    exit( EXIT_FAILURE );
+  }
+
+  // A guard page, so running off the end of the stack crashes.
+  mprotect( job->stack, 4096, PROT_NONE );
+
+  getcontext( &job->context );
+  job->context.uc_stack.ss_sp = job->stack;
+  job->context.uc_stack.ss_size = PROGRAM_STACK;
+  job->context.uc_link = NULL;
+  makecontext( &job->context, sliceMain, 0 );
+}
+
+/**
+ * Return the time since the given moment
+ * @param start the earlier time
+ * @return seconds since start
+*/
+static double elapsed( struct timespec const *start )
+{
+  struct timespec now;
+  clock_gettime( CLOCK_MONOTONIC, &now );
+  return ( now.tv_sec - start->tv_sec ) + ( now.tv_nsec - start->tv_nsec ) / 1e9;
+}
+
+/**
+ * Start routine for a worker thread with time slicing.  It repeatedly takes the program at the front
+ * of the run queue and runs it for one time slice.  A program that isn't finished goes on the back
+ * of the queue, so every program gets a turn within one slice for each program ahead of it.
+ * @param arg pointer to the shared Batch
+ * @return NULL
+*/
+static void *sliceWorker( void *arg )
+{
+  Batch *batch = (Batch *) arg;
+  ucontext_t home;
+  workerContext = &home;
+  setTimeSlice( slice, yieldToWorker );
+  traceThreadStart();
+
+  pthread_mutex_lock( &batch->lock );
+  while ( batch->unfinished > 0 ) {
+    if ( batch->queued == 0 ) {
+      pthread_cond_wait( &batch->runnable, &batch->lock );
+      continue;
+    }
+
+    Job *job = batch->list + batch->queue[ batch->head ];
+    batch->head = ( batch->head + 1 ) % batch->len;
+    batch->queued--;
+    pthread_mutex_unlock( &batch->lock );
+
+    double wait = elapsed( &job->queued );
+    if ( wait > job->maxWait )
+      job->maxWait = wait;
+    job->slices++;
+
+    // Run the program until its slice is over or it finishes.
+    if ( !job->stack )
+      startJob( job );
+    runningJob = job;
+    swapcontext( &home, &job->context );
+    runningJob = NULL;
+
+    pthread_mutex_lock( &batch->lock );
+    if ( job->finished ) {
+      munmap( job->stack, PROGRAM_STACK );
+      job->done = true;
+      batch->unfinished--;
+      pthread_cond_broadcast( &batch->finished );
+      if ( batch->unfinished == 0 )
+        pthread_cond_broadcast( &batch->runnable );
+    } else {
+      clock_gettime( CLOCK_MONOTONIC, &job->queued );
+      batch->queue[ ( batch->head + batch->queued++ ) % batch->len ] = job - batch->list;
+      pthread_cond_signal( &batch->runnable );
+    }
+  }
+  pthread_mutex_unlock( &batch->lock );
+
+  setTimeSlice( 0, NULL );
+  traceThreadEnd();
+  poolFlush();
+  return NULL;
+}
+
+/**
+ * Run every program in the list on the current thread, as each name is read.  This lets the list come
+ * from a pipe, with each program's output flushed as soon as it finishes.
+ * @param fp list of program files
+ * @return true if every program ran without an error
+*/
+static bool runSequential( FILE *fp )
+{
+  Environment *env = makeEnvironment();
+  bool ok = true;
+
+  char *line = NULL;
+  size_t cap = 0;
+  char *path;
+  while ( ( path = nextPath( fp, &line, &cap ) ) ) {
+    if ( !runFile( path, env ) )
+      ok = false;
+    clearEnvironment( env );
+
+    fflush( stdout );
+    fflush( stderr );
+  }
+
+  free( line );
+  freeEnvironment( env );
+  return ok;
+}
+
+/**
+ * Run every program in the list on a pool of worker threads.  Output from each program is printed
+ * in list order, as soon as it and all the programs before it are done.
+ * @param fp list of program files
+ * @param workers number of worker threads to start
+ * @param worker start routine for the worker threads, batchWorker() or sliceWorker()
+ * @param stats true if time slicing statistics should be reported at the end
+ * @return true if every program ran without an error
+*/
+static bool runParallel( FILE *fp, int workers, void *(*worker)( void * ), bool stats )
+{
+  Batch batch = { NULL, 0, INITIAL_CAPACITY, 0 };
+  batch.list = (Job *) malloc( batch.cap * sizeof( Job ) );
+  pthread_mutex_init( &batch.lock, NULL );
+  pthread_cond_init( &batch.finished, NULL );
+  pthread_cond_init( &batch.runnable, NULL );
+
+  // Read the whole list before starting the workers.
+  char *line = NULL;
+  size_t cap = 0;
+  char *path;
+  while ( ( path = nextPath( fp, &line, &cap ) ) ) {
+    if ( batch.len >= batch.cap ) {
+      batch.cap *= 2;
+      batch.list = (Job *) realloc( batch.list, batch.cap * sizeof( Job ) );
+    }
+    batch.list[ batch.len++ ] = (Job){ .path = strdup( path ) };
+  }
+  free( line );
+
+  // Every program starts out on the run queue, in list order.
+  batch.queue = (int *) malloc( ( batch.len ? batch.len : 1 ) * sizeof( int ) );
+  for ( int i = 0; i < batch.len; i++ ) {
+    batch.queue[ i ] = i;
+    clock_gettime( CLOCK_MONOTONIC, &batch.list[ i ].queued );
+  }
+  batch.queued = batch.unfinished = batch.len;
+
+  pthread_t thread[ MAX_WORKERS ];
+  for ( int i = 0; i < workers; i++ ) {
+    if ( pthread_create( thread + i, NULL, worker, &batch ) != 0 ) {
+      fprintf( stderr, "Can't create thread\n" );
+      exit( EXIT_FAILURE );
+    }
+  }
+
+  bool ok = true;
+  long slices = 0;
+  double maxWait = 0, totalWait = 0;
+  for ( int i = 0; i < batch.len; i++ ) {
+    Job *job = batch.list + i;
+
+    pthread_mutex_lock( &batch.lock );
+    while ( !job->done )
+      pthread_cond_wait( &batch.finished, &batch.lock );
+    pthread_mutex_unlock( &batch.lock );
+
+    fwrite( job->out, 1, job->outLen, stdout );
+    fwrite( job->err, 1, job->errLen, stderr );
+    fflush( stdout );
+    fflush( stderr );
+    if ( !job->ok )
+      ok = false;
+
+    slices += job->slices;
+    totalWait += job->maxWait;
+    if ( job->maxWait > maxWait )
+      maxWait = job->maxWait;
+
+    free( job->out );
+    free( job->err );
+    free( job->path );
+  }
+
+  for ( int i = 0; i < workers; i++ )
+    pthread_join( thread[ i ], NULL );
+
+  if ( stats )
+    fprintf( stderr, "%d programs, %ld time slices, longest wait %.3f ms, mean longest wait %.3f ms\n",
+             batch.len, slices, maxWait * 1000,
+             batch.len ? totalWait * 1000 / batch.len : 0.0 );
+
+  pthread_cond_destroy( &batch.runnable );
+  pthread_cond_destroy( &batch.finished );
+  pthread_mutex_destroy( &batch.lock );
+  free( batch.queue );
+  free( batch.list );
+  return ok;
+}
+
+//////////////////////////////////////////////////////////////////////
+// REPL mode
+
+/**
+ * Parse and run one statement typed into the REPL, in the environment kept from the statements
+ * before it.  After a syntax error, the rest of the line is thrown away so the next statement can
+ * start fresh on the line after it
+ * @param tok first token of the statement, already read
+ * @param env environment kept from one statement to the next
+ * @param time set to how long the statement took to run, in seconds
+ * @return true if the statement parsed and ran without an error
+*/
+static bool replStatement( char *tok, Environment *env, double *time )
+{
+  // Volatile, since it changes after setjmp() and is needed after an error.
+  Stmt *volatile stmt = NULL;
+
+  jmp_buf recover;
+  if ( setjmp( recover ) ) {
+    setRecoveryPoint( NULL );
+    if ( stmt )
+      stmt->destroy( stmt );
+    else
+      skipLine( stdin );
+    return false;
+  }
+  setRecoveryPoint( &recover );
+
+  stmt = parseStmt( tok, stdin );
+
+  if ( optimize )
+    hoistInvariants( stmt );
+
+#ifdef FLAT_EVAL
+  flattenStmt( stmt );
+#endif
+
+#ifdef JIT_EVAL
+  stmt = jitStmt( stmt );
+#endif
+
+  // Each statement gets the whole budget, so a runaway loop doesn't end
+  // the session.
+  setStatementBudget( budget );
+
+  struct timespec start;
+  clock_gettime( CLOCK_MONOTONIC, &start );
+  stmt->execute( stmt, env );
+  *time = elapsed( &start );
+
+  setRecoveryPoint( NULL );
+  stmt->destroy( stmt );
+  return true;
+}
+
+/**
+ * Read statements from standard input and run each one as soon as it's been parsed, until the end
+ * of the input.  Variables keep their values from one statement to the next, so data loaded once can
+ * be queried over and over.  After each statement, the time it took is printed to standard error.
+ * An error stops just the statement it happens in
+ * @return true if every statement ran without an error
+*/
+static bool runRepl()
+{
+  Environment *env = makeEnvironment();
+  bool interactive = isatty( STDIN_FILENO );
+  bool ok = true;
+
+  resetParser();
+  char tok[ MAX_TOKEN + 1 ];
+  while ( true ) {
+    if ( interactive ) {
+      fprintf( stderr, "> " );
+      fflush( stderr );
+    }
+    if ( !parseToken( tok, stdin ) )
+      break;
+
+    double time;
+    if ( replStatement( tok, env, &time ) ) {
+      // Make sure the statement's output comes before its time.
+      fflush( stdout );
+      fprintf( stderr, "time: %.3f ms\n", time * 1000 );
+    } else
+      ok = false;
+  }
+
+  freeEnvironment( env );
+  return ok;
+}
+
+/**
+ * Program starting point, calls all files to parse a file and correctly perform all specified statements and operations
+ * @param argc the number of command line arguments
+ * @param argv an array of char pointers which point to each command line argument
+ * @return program exit status
+*/
+int main( int argc, char *argv[] )
+{
+  // Name of the program file, or of the list of programs in batch mode.
+  char const *source = NULL;
+  bool batch = false;
+  bool repl = false;
+  int workers = 1;
+  bool poolStats = false;
+  bool schedStats = false;
+  bool trace = false;
+  char const *traceName = NULL;
+
+  for ( int i = 1; i < argc; i++ ) {
+    if ( strcmp( argv[ i ], "--batch" ) == 0 && i + 1 < argc && !source ) {
+      batch = true;
+      source = argv[ ++i ];
+    } else if ( strcmp( argv[ i ], "--repl" ) == 0 ) {
+      repl = true;
+    } else if ( strcmp( argv[ i ], "-j" ) == 0 && i + 1 < argc ) {
+      char extra;
+      if ( sscanf( argv[ ++i ], "%d%c", &workers, &extra ) != 1 ||
+           workers < 1 || workers > MAX_WORKERS )
+        usage();
+    } else if ( strcmp( argv[ i ], "--no-opt" ) == 0 ) {
+      optimize = false;
+    } else if ( strcmp( argv[ i ], "--pool-stats" ) == 0 ) {
+      poolStats = true;
+    } else if ( strcmp( argv[ i ], "--budget" ) == 0 && i + 1 < argc ) {
+      char extra;
+      if ( sscanf( argv[ ++i ], "%lu%c", &budget, &extra ) != 1 || budget < 1 )
+        usage();
+    } else if ( strcmp( argv[ i ], "--slice" ) == 0 && i + 1 < argc ) {
+      char extra;
+      if ( sscanf( argv[ ++i ], "%lu%c", &slice, &extra ) != 1 || slice < 1 )
+        usage();
+    } else if ( strcmp( argv[ i ], "--sched-stats" ) == 0 ) {
+      schedStats = true;
+    } else if ( strcmp( argv[ i ], "--trace" ) == 0 ) {
+      trace = true;
+    } else if ( strcmp( argv[ i ], "--trace-file" ) == 0 && i + 1 < argc ) {
+      trace = true;
+      traceName = argv[ ++i ];
+#ifdef JIT_EVAL
+    } else if ( strcmp( argv[ i ], "--no-jit" ) == 0 ) {
+      setJitEnabled( false );
+    } else if ( strcmp( argv[ i ], "--jit-threshold" ) == 0 && i + 1 < argc ) {
+      char extra;
+      int threshold;
+      if ( sscanf( argv[ ++i ], "%d%c", &threshold, &extra ) != 1 ||
+           threshold < 0 )
+        usage();
+      setJitThreshold( threshold );
+#endif
+    } else if ( !source ) {
+      source = argv[ i ];
+    } else
+      usage();
+  }
+
+  // The REPL reads statements from standard input, instead of a file.
+  if ( repl ? source || batch : !source )
+    usage();
+  if ( ( ( workers > 1 || slice ) && !batch ) || ( schedStats && !slice ) )
+    usage();
+
+  // Open the program's source, or the list of programs.
+  FILE *fp = repl || ( strcmp( source, "-" ) == 0 && batch ) ? stdin : fopen( source, "r" );
+  if ( !fp ) {
+    perror( source );
+    exit( EXIT_FAILURE );
+  }
+
+  // Statements are only traced if it's asked for.  Traces are dumped to
+  // the trace file, or along with each program's error messages if there
+  // isn't one.
+  int traceFd = -1;
+  if ( traceName ) {
+    traceFd = open( traceName, O_WRONLY | O_CREAT | O_APPEND, 0644 );
+    if ( traceFd < 0 ) {
+      perror( traceName );
+      exit( EXIT_FAILURE );
+    }
+  }
+  if ( trace )
+    startTrace( traceFd );
+  traceThreadStart();
+
+  bool ok;
+  if ( batch ) {
+    if ( slice )
+      ok = runParallel( fp, workers, sliceWorker, schedStats );
+    else if ( workers > 1 )
+      ok = runParallel( fp, workers, batchWorker, false );
+    else
+      ok = runSequential( fp );
+  } else if ( repl ) {
+    ok = runRepl();
+  } else {
+    // Environment, for storing variable values.
+    Environment *env = makeEnvironment();
+    ok = runProgram( fp, env );
+    freeEnvironment( env );
+  }
+
+  // We're done, close the input file.
+  if ( fp != stdin )
+    fclose( fp );
+
+  traceThreadEnd();
+  if ( traceFd >= 0 )
+    close( traceFd );
+
+  poolFlush();
+  if ( poolStats )
+    poolReport( stderr );
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
 }
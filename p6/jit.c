@@ -0,0 +1,584 @@
+/**
+ * @file jit.c
+ * @author Jake Donovan (jmpatte8)
+ * Compiles hot while loops that only work with int variables into native x86-64 code.  The native
+ * code keeps every variable the loop uses in an array of ints, loaded from the environment before
+ * the loop starts and stored back when it's done.
+*/
+
+#define _DEFAULT_SOURCE
+
+#include "jit.h"
+#include "flat.h"
+#include "runtime.h"
+#include "trace.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+/** Initial capacity for resizable arrays. */
+#define INITIAL_CAPACITY 5
+
+/** True if loops should be compiled at all. */
+static bool jitEnabled = true;
+
+/** Iterations a loop runs in the interpreter before it's compiled. */
+static int jitThreshold = JIT_THRESHOLD;
+
+/** Native code for a loop.  It runs the whole loop using the given values
+    for its variables, returning zero when the loop is done or non-zero if
+    it stopped on a division by zero. */
+typedef int (*NativeLoop)( int *vars );
+
+/** Representation for a while loop that can be compiled, a subclass of Stmt. */
+typedef struct {
+  void (*execute)( Stmt *stmt, Environment *env );
+  void (*destroy)( Stmt *stmt );
+  int line;
+  unsigned int trace;
+
+  /** The original while statement, used until the loop is compiled. */
+  Stmt *loop;
+
+  /** Number of iterations run by the interpreter so far. */
+  int count;
+
+  /** True once we've tried to compile the loop. */
+  bool tried;
+
+  /** Names of the variables the loop uses, pointing into the loop. */
+  char const **names;
+  /** Cached position of each variable in the environment. */
+  int *slots;
+  /** True for each variable the loop assigns to. */
+  bool *assigned;
+  /** Number of variables the loop uses. */
+  int vars;
+  /** Capacity of the variable arrays. */
+  int cap;
+
+  /** Entry point of the compiled code, or NULL if it isn't compiled. */
+  NativeLoop code;
+  /** Executable buffer holding the code. */
+  void *mem;
+  /** Size of the executable buffer. */
+  size_t size;
+} JitWhile;
+
+/** Documented in the header. */
+void setJitEnabled( bool enabled )
+{
+  jitEnabled = enabled;
+}
+
+/** Documented in the header. */
+void setJitThreshold( int iterations )
+{
+  jitThreshold = iterations;
+}
+
+/**
+ * Look past a flattened expression to the tree it was made from
+ * @param expr the expression to check
+ * @return the tree for expr
+*/
+static Expr *treeOf( Expr *expr )
+{
+  Expr *tree = flatTree( expr );
+  return tree ? tree : expr;
+}
+
+/**
+ * Report whether an expression can be compiled, using nothing but int operations on variables
+ * @param expr the expression to check
+ * @return true if the expression can be compiled
+*/
+static bool intOnlyExpr( Expr *expr )
+{
+  expr = treeOf( expr );
+
+  switch ( exprKind( expr ) ) {
+  case LiteralKind:
+  case VariableKind:
+    return true;
+
+  case AddKind:
+  case SubKind:
+  case MulKind:
+  case DivKind:
+  case AndKind:
+  case OrKind:
+  case LessKind:
+  case EqualsKind:
+    return intOnlyExpr( *exprChild( expr, 0 ) ) &&
+      intOnlyExpr( *exprChild( expr, 1 ) );
+
+  default:
+    return false;
+  }
+}
+
+/**
+ * Report whether a statement can be compiled.  It can contain assignments to variables, ifs, whiles
+ * and compound statements, with int-only expressions.
+ * @param stmt the statement to check
+ * @return true if the statement can be compiled
+*/
+static bool intOnlyStmt( Stmt *stmt )
+{
+  switch ( stmtKind( stmt ) ) {
+  case AssignmentKind:
+    return stmtExprCount( stmt ) == 1 && intOnlyExpr( *stmtExpr( stmt, 0 ) );
+
+  case IfKind:
+  case WhileKind:
+    if ( !intOnlyExpr( *stmtExpr( stmt, 0 ) ) )
+      return false;
+    // Fall through to check the body.
+
+  case CompoundKind:
+    for ( int i = 0; i < stmtBodyCount( stmt ); i++ )
+      if ( !intOnlyStmt( *stmtBody( stmt, i ) ) )
+        return false;
+    return true;
+
+  default:
+    return false;
+  }
+}
+
+/**
+ * Return the index of a variable used by the loop, adding it if it's new
+ * @param this the loop using the variable
+ * @param name name of the variable
+ * @return index of the variable in the loop's array of values
+*/
+static int varIndex( JitWhile *this, char const *name )
+{
+  for ( int i = 0; i < this->vars; i++ )
+    if ( strcmp( this->names[ i ], name ) == 0 )
+      return i;
+
+  if ( this->vars >= this->cap ) {
+    this->cap *= 2;
+    this->names = (char const **) realloc( this->names, this->cap * sizeof( char const * ) );
+    this->slots = (int *) realloc( this->slots, this->cap * sizeof( int ) );
+    this->assigned = (bool *) realloc( this->assigned, this->cap * sizeof( bool ) );
+  }
+
+  this->names[ this->vars ] = name;
+  this->slots[ this->vars ] = 0;
+  this->assigned[ this->vars ] = false;
+  return this->vars++;
+}
+
+#if defined( __x86_64__ )
+
+//////////////////////////////////////////////////////////////////////
+// x86-64 code generation.  Expressions leave their value in eax, using
+// the machine stack for intermediate values.  rdi points to the array
+// of variable values the whole time.
+
+/** Machine code being built for a loop. */
+typedef struct {
+  /** Resizable array of bytes. */
+  unsigned char *buf;
+  /** Number of bytes of code. */
+  int len;
+  /** Capacity of the array. */
+  int cap;
+} Code;
+
+/** Offset of the code that returns a division by zero.  It's at the very
+    start of the buffer, so every jump to it is backward. */
+#define ERROR_STUB 0
+
+/**
+ * Append some bytes to the machine code
+ * @param code the code we're building
+ * @param bytes the bytes to add
+ * @param n number of bytes to add
+*/
+static void emit( Code *code, unsigned char const *bytes, int n )
+{
+  while ( code->len + n > code->cap ) {
+    code->cap *= 2;
+    code->buf = (unsigned char *) realloc( code->buf, code->cap );
+  }
+
+  memcpy( code->buf + code->len, bytes, n );
+  code->len += n;
+}
+
+/** Convenience macro to emit a list of literal bytes. */
+#define EMIT( code, ... ) \
+  emit( code, (unsigned char const []){ __VA_ARGS__ }, \
+        sizeof( (unsigned char const []){ __VA_ARGS__ } ) )
+
+/**
+ * Append a 32-bit little-endian value to the machine code
+ * @param code the code we're building
+ * @param val value to add
+*/
+static void emitInt( Code *code, int val )
+{
+  EMIT( code, val & 0xFF, ( val >> 8 ) & 0xFF, ( val >> 16 ) & 0xFF,
+        ( val >> 24 ) & 0xFF );
+}
+
+/**
+ * Store a 32-bit jump offset at the given position, relative to the end of the offset
+ * @param code the code we're building
+ * @param pos position of the offset in the code
+ * @param target position the jump should go to
+*/
+static void patch( Code *code, int pos, int target )
+{
+  int rel = target - ( pos + 4 );
+  for ( int i = 0; i < 4; i++ )
+    code->buf[ pos + i ] = ( rel >> ( 8 * i ) ) & 0xFF;
+}
+
+/**
+ * Append a conditional jump on the zero flag, to be patched later
+ * @param code the code we're building
+ * @param ifZero true for jz, false for jnz
+ * @return position of the jump offset
+*/
+static int emitJump( Code *code, bool ifZero )
+{
+  EMIT( code, 0x0F, ifZero ? 0x84 : 0x85 );
+  emitInt( code, 0 );
+  return code->len - 4;
+}
+
+/**
+ * Append code to evaluate an expression, leaving its value in eax
+ * @param this the loop being compiled
+ * @param code the code we're building
+ * @param expr the expression to compile
+*/
+static void compileExpr( JitWhile *this, Code *code, Expr *expr )
+{
+  expr = treeOf( expr );
+  ExprKind kind = exprKind( expr );
+  int pos;
+
+  switch ( kind ) {
+  case LiteralKind:
+    // mov eax, imm32
+    EMIT( code, 0xB8 );
+    emitInt( code, literalValue( expr ) );
+    return;
+
+  case VariableKind:
+    // mov eax, [rdi + disp32]
+    EMIT( code, 0x8B, 0x87 );
+    emitInt( code, varIndex( this, variableName( expr ) ) * sizeof( int ) );
+    return;
+
+  case AndKind:
+  case OrKind:
+    // The result is the left operand if it settles the answer, otherwise
+    // the right operand, same as the interpreter.
+    compileExpr( this, code, *exprChild( expr, 0 ) );
+    EMIT( code, 0x85, 0xC0 );                 // test eax, eax
+    pos = emitJump( code, kind == AndKind );
+    compileExpr( this, code, *exprChild( expr, 1 ) );
+    patch( code, pos, code->len );
+    return;
+
+  default:
+    break;
+  }
+
+  // Everything else is a binary operator, with the left operand in eax and
+  // the right one in ecx.
+  compileExpr( this, code, *exprChild( expr, 0 ) );
+  EMIT( code, 0x50 );                         // push rax
+  compileExpr( this, code, *exprChild( expr, 1 ) );
+  EMIT( code, 0x89, 0xC1,                     // mov ecx, eax
+        0x58 );                               // pop rax
+
+  switch ( kind ) {
+  case AddKind:
+    EMIT( code, 0x01, 0xC8 );                 // add eax, ecx
+    break;
+  case SubKind:
+    EMIT( code, 0x29, 0xC8 );                 // sub eax, ecx
+    break;
+  case MulKind:
+    EMIT( code, 0x0F, 0xAF, 0xC1 );           // imul eax, ecx
+    break;
+  case DivKind:
+    EMIT( code, 0x85, 0xC9 );                 // test ecx, ecx
+    patch( code, emitJump( code, true ), ERROR_STUB );
+    EMIT( code, 0x99,                         // cdq
+          0xF7, 0xF9 );                       // idiv ecx
+    break;
+  case LessKind:
+    EMIT( code, 0x39, 0xC8,                   // cmp eax, ecx
+          0x0F, 0x9C, 0xC0,                   // setl al
+          0x0F, 0xB6, 0xC0 );                 // movzx eax, al
+    break;
+  default:
+    EMIT( code, 0x39, 0xC8,                   // cmp eax, ecx
+          0x0F, 0x94, 0xC0,                   // sete al
+          0x0F, 0xB6, 0xC0 );                 // movzx eax, al
+    break;
+  }
+}
+
+/**
+ * Append code to run a statement
+ * @param this the loop being compiled
+ * @param code the code we're building
+ * @param stmt the statement to compile
+*/
+static void compileStmt( JitWhile *this, Code *code, Stmt *stmt )
+{
+  int top, pos;
+
+  switch ( stmtKind( stmt ) ) {
+  case AssignmentKind:
+    compileExpr( this, code, *stmtExpr( stmt, 0 ) );
+    pos = varIndex( this, assignmentName( stmt ) );
+    this->assigned[ pos ] = true;
+    // mov [rdi + disp32], eax
+    EMIT( code, 0x89, 0x87 );
+    emitInt( code, pos * sizeof( int ) );
+    break;
+
+  case IfKind:
+    compileExpr( this, code, *stmtExpr( stmt, 0 ) );
+    EMIT( code, 0x85, 0xC0 );                 // test eax, eax
+    pos = emitJump( code, true );
+    compileStmt( this, code, *stmtBody( stmt, 0 ) );
+    patch( code, pos, code->len );
+    break;
+
+  case WhileKind:
+    top = code->len;
+    compileExpr( this, code, *stmtExpr( stmt, 0 ) );
+    EMIT( code, 0x85, 0xC0 );                 // test eax, eax
+    pos = emitJump( code, true );
+    compileStmt( this, code, *stmtBody( stmt, 0 ) );
+    EMIT( code, 0xE9 );                       // jmp top
+    emitInt( code, 0 );
+    patch( code, code->len - 4, top );
+    patch( code, pos, code->len );
+    break;
+
+  default:
+    for ( int i = 0; i < stmtBodyCount( stmt ); i++ )
+      compileStmt( this, code, *stmtBody( stmt, i ) );
+    break;
+  }
+}
+
+/**
+ * Compile a loop into an executable buffer
+ * @param this the loop to compile, which gets its code and variable list filled in
+ * @return true if the loop was compiled
+*/
+static bool compileLoop( JitWhile *this )
+{
+  Code code = { NULL, 0, INITIAL_CAPACITY };
+  code.buf = (unsigned char *) malloc( code.cap );
+
+  // Returning a division by zero, at ERROR_STUB.
+  EMIT( &code, 0xB8, 0x01, 0x00, 0x00, 0x00,  // mov eax, 1
+        0x48, 0x89, 0xEC,                     // mov rsp, rbp
+        0x5D,                                 // pop rbp
+        0xC3 );                               // ret
+
+  // Entry point, then the loop and a normal return.
+  int entry = code.len;
+  EMIT( &code, 0x55,                          // push rbp
+        0x48, 0x89, 0xE5 );                   // mov rbp, rsp
+  compileStmt( this, &code, this->loop );
+  EMIT( &code, 0x31, 0xC0,                    // xor eax, eax
+        0x5D,                                 // pop rbp
+        0xC3 );                               // ret
+
+  // Copy the code into its own pages, then make them executable but no
+  // longer writable.
+  void *mem = mmap( NULL, code.len, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+  if ( mem == MAP_FAILED ) {
+    free( code.buf );
+    return false;
+  }
+
+  memcpy( mem, code.buf, code.len );
+  free( code.buf );
+  if ( mprotect( mem, code.len, PROT_READ | PROT_EXEC ) != 0 ) {
+    munmap( mem, code.len );
+    return false;
+  }
+
+  this->mem = mem;
+  this->code = (NativeLoop) ( (unsigned char *) mem + entry );
+  this->size = code.len;
+  return true;
+}
+
+/**
+ * Free the executable buffer for a compiled loop
+ * @param this the compiled loop
+*/
+static void freeCode( JitWhile *this )
+{
+  munmap( this->mem, this->size );
+}
+
+#else
+
+/**
+ * On other machines, loops are never compiled
+ * @param this the loop to compile
+ * @return false, since there's no code generator
+*/
+static bool compileLoop( JitWhile *this )
+{
+  return false;
+}
+
+/**
+ * Nothing to free, since no loop is ever compiled
+ * @param this the loop
+*/
+static void freeCode( JitWhile *this )
+{
+}
+
+#endif
+
+/**
+ * Run the compiled code for a loop, if every variable it uses holds an int right now
+ * @param this the compiled loop
+ * @param env environment holding the variables
+ * @return true if the loop ran, or false if the type guard failed
+*/
+static bool runNative( JitWhile *this, Environment *env )
+{
+  // Load the variables, checking their types.  Extra element, since the
+  // loop might not use any variables.
+  int vals[ this->vars + 1 ];
+  for ( int i = 0; i < this->vars; i++ ) {
+    Value v = lookupCached( env, this->names[ i ], this->slots + i );
+    if ( v.vtype != IntType )
+      return false;
+    vals[ i ] = v.ival;
+  }
+
+  int status = this->code( vals );
+
+  // Store back everything the loop could have changed.
+  for ( int i = 0; i < this->vars; i++ )
+    if ( this->assigned[ i ] )
+      setVariable( env, this->names[ i ], (Value){ IntType, .ival = vals[ i ] } );
+
+  // Let the interpreter report the error, just as if it had hit it.
+  if ( status )
+    applyDiv( (Value){ IntType, .ival = 0 }, (Value){ IntType, .ival = 0 } );
+
+  return true;
+}
+
+/** Implementation of execute for a loop that can be compiled. */
+static void executeJitWhile( Stmt *stmt, Environment *env )
+{
+  JitWhile *this = (JitWhile *) stmt;
+  Expr *cond = *stmtExpr( this->loop, 0 );
+  Stmt *body = *stmtBody( this->loop, 0 );
+  countStatement();
+  traceStatement( stmt );
+
+  while ( true ) {
+    // Once the loop is hot, compile it.
+    if ( !this->tried && this->count >= jitThreshold ) {
+      this->tried = true;
+      compileLoop( this );
+    }
+
+    // Finish the loop in native code, if we can.  Native code doesn't count
+    // statements, so it can't run if the program could be stopped or paused.
+    if ( this->code && !budgetActive() && runNative( this, env ) )
+      return;
+
+    // Otherwise, run one more iteration in the interpreter.
+    Value result = cond->eval( cond, env );
+    requireIntType( &result );
+    if ( !result.ival )
+      return;
+
+    body->execute( body, env );
+    if ( !this->tried )
+      this->count++;
+
+    countStatement();
+    traceStatement( stmt );
+    checkBudget();
+  }
+}
+
+/** Implementation of destroy for a loop that can be compiled. */
+static void destroyJitWhile( Stmt *stmt )
+{
+  JitWhile *this = (JitWhile *) stmt;
+
+  if ( this->code )
+    freeCode( this );
+  free( this->names );
+  free( this->slots );
+  free( this->assigned );
+  this->loop->destroy( this->loop );
+  free( this );
+}
+
+/**
+ * Wrap a while loop so it gets compiled once it's hot
+ * @param loop the while statement, which the new statement takes ownership of
+ * @return the new statement
+*/
+static Stmt *makeJitWhile( Stmt *loop )
+{
+  JitWhile *this = (JitWhile *) malloc( sizeof( JitWhile ) );
+  this->execute = executeJitWhile;
+  this->destroy = destroyJitWhile;
+  this->line = loop->line;
+  this->trace = loop->trace;
+  this->loop = loop;
+  this->count = 0;
+  this->tried = false;
+
+  this->vars = 0;
+  this->cap = INITIAL_CAPACITY;
+  this->names = (char const **) malloc( this->cap * sizeof( char const * ) );
+  this->slots = (int *) malloc( this->cap * sizeof( int ) );
+  this->assigned = (bool *) malloc( this->cap * sizeof( bool ) );
+
+  this->code = NULL;
+  this->mem = NULL;
+  this->size = 0;
+
+  return (Stmt *) this;
+}
+
+/** Documented in the header. */
+Stmt *jitStmt( Stmt *stmt )
+{
+  if ( !jitEnabled )
+    return stmt;
+
+  if ( stmtKind( stmt ) == WhileKind && intOnlyStmt( stmt ) )
+    return makeJitWhile( stmt );
+
+  for ( int i = 0; i < stmtBodyCount( stmt ); i++ ) {
+    Stmt **slot = stmtBody( stmt, i );
+    *slot = jitStmt( *slot );
+  }
+
+  return stmt;
+}
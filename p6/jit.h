@@ -0,0 +1,45 @@
+/**
+  @file jit.h
+  @author Jake Donovan (jmpatte8)
+
+  An optional tier above the expression engines.  While loops that only
+  do integer arithmetic on variables count their iterations, and once a
+  loop gets hot it's compiled to native x86-64 code in an executable
+  buffer.  Before the native code runs, a type guard checks that every
+  variable the loop uses holds an int; if not, the loop just keeps
+  running in the interpreter.  On other machines, loops are never
+  compiled.
+*/
+
+#ifndef _JIT_H_
+#define _JIT_H_
+
+#include <stdbool.h>
+#include "syntax.h"
+
+/** Default number of iterations a loop runs in the interpreter before
+    it's compiled. */
+#define JIT_THRESHOLD 100
+
+/** Turn the JIT on or off for the whole process.  It's on by default.
+    This should be called before any programs start running.
+    @param enabled false to never compile anything.
+ */
+void setJitEnabled( bool enabled );
+
+/** Change how many iterations a loop runs in the interpreter before it's
+    compiled.  This should be called before any programs start running.
+    @param iterations new threshold, zero to compile on the first iteration.
+ */
+void setJitThreshold( int iterations );
+
+/** Wrap every while loop in the given statement that could be compiled,
+    including the statement itself, so the loop gets compiled once it's
+    hot.  Loops nested inside a wrapped loop are compiled along with it.
+    @param stmt statement to check for loops.
+    @return the statement to run in place of stmt, which may be stmt
+    itself.
+ */
+Stmt *jitStmt( Stmt *stmt );
+
+#endif
@@ -0,0 +1,641 @@
+/**
+ * @file optimize.c
+ * @author Jake Donovan (jmpatte8)
+ * Loop-invariant code motion.  An invariant expression is replaced with one that saves its value the
+ * first time it's evaluated in a run of the loop.  Saved values are thrown away when the loop's condition
+ * comes out false, and when a push or element assignment might change a sequence they were computed from.
+ * This file also has the liveness analysis that releases sequences once the variables holding them are dead.
+*/
+
+#include "optimize.h"
+#include <stdlib.h>
+#include <string.h>
+
+/** Initial capacity for resizable arrays. */
+#define INITIAL_CAPACITY 5
+
+/** Resizable list of variable names, pointing into the parsed program. */
+typedef struct {
+  char const **list;
+  int len;
+  int cap;
+} NameList;
+
+/** Representation for a hoisted expression, a subclass of Expr. */
+typedef struct {
+  Value (*eval)( Expr *expr, Environment *env );
+  void (*destroy)( Expr *expr );
+
+  /** The invariant expression. */
+  Expr *expr;
+
+  /** True if value holds the result for this run of the loop. */
+  bool valid;
+
+  /** Saved result. */
+  Value value;
+
+  /** Variables the expression reads. */
+  NameList vars;
+
+  /** Cached environment position for each variable. */
+  int *slots;
+
+  /** Sequence each variable held when the value was saved, or NULL if it
+      held an int. */
+  Sequence **seqs;
+} CachedExpr;
+
+/** Resizable list of hoisted expressions. */
+typedef struct {
+  CachedExpr **list;
+  int len;
+  int cap;
+} CacheList;
+
+/** Condition of a loop with hoisted expressions, a subclass of Expr.  When
+    the condition is false, the loop is done, so its saved values are
+    thrown away. */
+typedef struct {
+  Value (*eval)( Expr *expr, Environment *env );
+  void (*destroy)( Expr *expr );
+
+  /** The original condition. */
+  Expr *cond;
+
+  /** Hoisted expressions belonging to this loop. */
+  CacheList caches;
+} LoopExit;
+
+/** Wrapper for the last expression evaluated before a push or element
+    assignment changes a sequence, a subclass of Expr.  It throws away
+    saved values that depend on the sequence about to change. */
+typedef struct {
+  Value (*eval)( Expr *expr, Environment *env );
+  void (*destroy)( Expr *expr );
+
+  /** The original expression. */
+  Expr *expr;
+
+  /** Variable holding the sequence that's changed, or NULL if we don't
+      know which sequence it is. */
+  char const *target;
+
+  /** Cached environment position for the target. */
+  int slot;
+
+  /** Hoisted expressions in every loop around the statement. */
+  CacheList caches;
+} Invalidator;
+
+/**
+ * Add a name to a list, if it's not already there
+ * @param names the list to add to
+ * @param name the name to add
+*/
+static void addName( NameList *names, char const *name )
+{
+  for ( int i = 0; i < names->len; i++ )
+    if ( strcmp( names->list[ i ], name ) == 0 )
+      return;
+
+  if ( names->len >= names->cap ) {
+    names->cap = names->cap ? names->cap * 2 : INITIAL_CAPACITY;
+    names->list = (char const **) realloc( names->list, names->cap * sizeof( char const * ) );
+  }
+  names->list[ names->len++ ] = name;
+}
+
+/**
+ * Report whether a name is in a list
+ * @param names the list to check
+ * @param name the name to look for
+ * @return true if the name is in the list
+*/
+static bool hasName( NameList const *names, char const *name )
+{
+  for ( int i = 0; i < names->len; i++ )
+    if ( strcmp( names->list[ i ], name ) == 0 )
+      return true;
+  return false;
+}
+
+/**
+ * Add a hoisted expression to a list
+ * @param caches the list to add to
+ * @param cached the expression to add
+*/
+static void addCache( CacheList *caches, CachedExpr *cached )
+{
+  if ( caches->len >= caches->cap ) {
+    caches->cap = caches->cap ? caches->cap * 2 : INITIAL_CAPACITY;
+    caches->list = (CachedExpr **) realloc( caches->list, caches->cap * sizeof( CachedExpr * ) );
+  }
+  caches->list[ caches->len++ ] = cached;
+}
+
+/**
+ * Make a copy of a list of hoisted expressions
+ * @param caches the list to copy
+ * @return a new list with the same expressions
+*/
+static CacheList copyCaches( CacheList const *caches )
+{
+  CacheList copy = { NULL, 0, 0 };
+  for ( int i = 0; i < caches->len; i++ )
+    addCache( &copy, caches->list[ i ] );
+  return copy;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Hoisted expressions
+
+/** Implementation of eval for a hoisted expression. */
+static Value evalCached( Expr *expr, Environment *env )
+{
+  CachedExpr *this = (CachedExpr *) expr;
+
+  if ( this->valid )
+    return this->value;
+
+  // Only int results are saved, since those don't need reference counting.
+  Value v = this->expr->eval( this->expr, env );
+  if ( v.vtype == IntType ) {
+    this->valid = true;
+    this->value = v;
+
+    // Remember which sequences the value came from.
+    for ( int i = 0; i < this->vars.len; i++ ) {
+      Value var = lookupCached( env, this->vars.list[ i ], this->slots + i );
+      this->seqs[ i ] = var.vtype == SeqType ? var.sval : NULL;
+    }
+  }
+
+  return v;
+}
+
+/** Implementation of destroy for a hoisted expression. */
+static void destroyCached( Expr *expr )
+{
+  CachedExpr *this = (CachedExpr *) expr;
+
+  this->expr->destroy( this->expr );
+  free( this->vars.list );
+  free( this->slots );
+  free( this->seqs );
+  free( this );
+}
+
+/**
+ * Add the name of every variable an expression reads to a list
+ * @param expr the expression to check
+ * @param names the list to add to
+*/
+static void collectReads( Expr *expr, NameList *names )
+{
+  if ( exprKind( expr ) == VariableKind )
+    addName( names, variableName( expr ) );
+  else if ( expr->eval == evalCached )
+    collectReads( ((CachedExpr *) expr)->expr, names );
+  else
+    for ( int i = 0; i < exprCount( expr ); i++ )
+      collectReads( *exprChild( expr, i ), names );
+}
+
+/**
+ * Make a hoisted version of an invariant expression
+ * @param expr the expression, which the new one takes ownership of
+ * @return the new hoisted expression
+*/
+static CachedExpr *makeCached( Expr *expr )
+{
+  CachedExpr *this = (CachedExpr *) malloc( sizeof( CachedExpr ) );
+  this->eval = evalCached;
+  this->destroy = destroyCached;
+  this->expr = expr;
+  this->valid = false;
+
+  this->vars = (NameList){ NULL, 0, 0 };
+  collectReads( expr, &this->vars );
+  this->slots = (int *) calloc( this->vars.len + 1, sizeof( int ) );
+  this->seqs = (Sequence **) calloc( this->vars.len + 1, sizeof( Sequence * ) );
+
+  return this;
+}
+
+/**
+ * Report whether a saved value was computed from the given sequence
+ * @param this the hoisted expression
+ * @param seq the sequence to look for
+ * @return true if one of the expression's variables held seq
+*/
+static bool dependsOn( CachedExpr const *this, Sequence const *seq )
+{
+  for ( int i = 0; i < this->vars.len; i++ )
+    if ( this->seqs[ i ] == seq )
+      return true;
+  return false;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Loop conditions
+
+/** Implementation of eval for the condition of a loop with hoisted expressions. */
+static Value evalLoopExit( Expr *expr, Environment *env )
+{
+  LoopExit *this = (LoopExit *) expr;
+
+  Value v = this->cond->eval( this->cond, env );
+  if ( v.vtype == IntType && v.ival == 0 )
+    for ( int i = 0; i < this->caches.len; i++ )
+      this->caches.list[ i ]->valid = false;
+
+  return v;
+}
+
+/** Implementation of destroy for the condition of a loop with hoisted expressions. */
+static void destroyLoopExit( Expr *expr )
+{
+  LoopExit *this = (LoopExit *) expr;
+
+  this->cond->destroy( this->cond );
+  free( this->caches.list );
+  free( this );
+}
+
+//////////////////////////////////////////////////////////////////////
+// Invalidation
+
+/** Implementation of eval for an expression evaluated just before a sequence changes. */
+static Value evalInvalidator( Expr *expr, Environment *env )
+{
+  Invalidator *this = (Invalidator *) expr;
+
+  Value v = this->expr->eval( this->expr, env );
+
+  // Find the sequence that's about to change, if we know it.
+  Sequence *seq = NULL;
+  if ( this->target ) {
+    Value t = lookupCached( env, this->target, &this->slot );
+    if ( t.vtype != SeqType )
+      return v;
+    seq = t.sval;
+  }
+
+  for ( int i = 0; i < this->caches.len; i++ ) {
+    CachedExpr *cached = this->caches.list[ i ];
+    if ( cached->valid && ( !seq || dependsOn( cached, seq ) ) )
+      cached->valid = false;
+  }
+
+  return v;
+}
+
+/** Implementation of destroy for an expression evaluated just before a sequence changes. */
+static void destroyInvalidator( Expr *expr )
+{
+  Invalidator *this = (Invalidator *) expr;
+
+  this->expr->destroy( this->expr );
+  free( this->caches.list );
+  free( this );
+}
+
+//////////////////////////////////////////////////////////////////////
+// Finding invariant expressions
+
+/** Set in the result of classify() if an expression is invariant. */
+#define INVARIANT 0x1
+
+/** Set in the result of classify() if an expression reads a sequence,
+    so it's worth hoisting. */
+#define WORTH 0x2
+
+/**
+ * Classify an expression for hoisting
+ * @param expr the expression to check
+ * @param written variables the loop assigns to
+ * @return a combination of INVARIANT and WORTH
+*/
+static int classify( Expr *expr, NameList const *written )
+{
+  ExprKind kind = exprKind( expr );
+
+  switch ( kind ) {
+  case LiteralKind:
+    return INVARIANT;
+
+  case VariableKind:
+    return hasName( written, variableName( expr ) ) ? 0 : INVARIANT;
+
+  case SeqInitKind:
+    // Every evaluation makes a new sequence, so it can't be hoisted.
+    return 0;
+
+  case OtherExprKind:
+    // Something hoisted out of an enclosing loop is invariant here too.
+    return expr->eval == evalCached ? INVARIANT : 0;
+
+  default: {
+    int flags = INVARIANT;
+    for ( int i = 0; i < exprCount( expr ); i++ ) {
+      int child = classify( *exprChild( expr, i ), written );
+      flags = ( flags & child & INVARIANT ) | ( ( flags | child ) & WORTH );
+    }
+
+    if ( kind == LenKind || kind == IndexKind || kind == SortKind || kind == FindKind )
+      flags |= WORTH;
+    return flags;
+  }
+  }
+}
+
+/**
+ * Replace the largest invariant parts of an expression with hoisted expressions
+ * @param slot address of the pointer to the expression
+ * @param written variables the loop assigns to
+ * @param caches list of the loop's hoisted expressions, added to as we go
+*/
+static void hoistExpr( Expr **slot, NameList const *written, CacheList *caches )
+{
+  Expr *expr = *slot;
+
+  if ( classify( expr, written ) == ( INVARIANT | WORTH ) ) {
+    CachedExpr *cached = makeCached( expr );
+    addCache( caches, cached );
+    *slot = (Expr *) cached;
+    return;
+  }
+
+  if ( exprKind( expr ) != OtherExprKind )
+    for ( int i = 0; i < exprCount( expr ); i++ )
+      hoistExpr( exprChild( expr, i ), written, caches );
+}
+
+/**
+ * Hoist invariant expressions everywhere in a statement
+ * @param stmt the statement to check
+ * @param written variables the loop assigns to
+ * @param caches list of the loop's hoisted expressions, added to as we go
+*/
+static void hoistStmt( Stmt *stmt, NameList const *written, CacheList *caches )
+{
+  for ( int i = 0; i < stmtExprCount( stmt ); i++ )
+    hoistExpr( stmtExpr( stmt, i ), written, caches );
+
+  for ( int i = 0; i < stmtBodyCount( stmt ); i++ )
+    hoistStmt( *stmtBody( stmt, i ), written, caches );
+}
+
+/**
+ * Add every variable a statement assigns to a list.  Assigning to an element of a sequence changes the
+ * sequence, not the variable, so that's handled separately.
+ * @param stmt the statement to check
+ * @param written the list to add to
+*/
+static void collectWrites( Stmt *stmt, NameList *written )
+{
+  if ( stmtKind( stmt ) == AssignmentKind && stmtExprCount( stmt ) == 1 )
+    addName( written, assignmentName( stmt ) );
+
+  for ( int i = 0; i < stmtBodyCount( stmt ); i++ )
+    collectWrites( *stmtBody( stmt, i ), written );
+}
+
+// Prototype, so loops can be optimized from inside visit().
+static void optimizeLoop( Stmt *loop, CacheList const *outer );
+
+/**
+ * Look for loops to optimize inside a statement, and make pushes and element assignments invalidate
+ * the hoisted expressions of the loops they're in
+ * @param stmt the statement to check
+ * @param context hoisted expressions of every loop around the statement
+*/
+static void visit( Stmt *stmt, CacheList const *context )
+{
+  StmtKind kind = stmtKind( stmt );
+
+  if ( kind == WhileKind ) {
+    optimizeLoop( stmt, context );
+    return;
+  }
+
+  // For both push and element assignment, expression 1 is the last one
+  // evaluated before the sequence changes.
+  if ( context->len > 0 && stmtExprCount( stmt ) == 2 &&
+       ( kind == PushKind || kind == AssignmentKind ) ) {
+    Invalidator *inv = (Invalidator *) malloc( sizeof( Invalidator ) );
+    inv->eval = evalInvalidator;
+    inv->destroy = destroyInvalidator;
+    inv->expr = *stmtExpr( stmt, 1 );
+    inv->slot = 0;
+    inv->caches = copyCaches( context );
+
+    if ( kind == AssignmentKind )
+      inv->target = assignmentName( stmt );
+    else {
+      Expr *seq = *stmtExpr( stmt, 0 );
+      inv->target = exprKind( seq ) == VariableKind ? variableName( seq ) : NULL;
+    }
+
+    *stmtExpr( stmt, 1 ) = (Expr *) inv;
+  }
+
+  for ( int i = 0; i < stmtBodyCount( stmt ); i++ )
+    visit( *stmtBody( stmt, i ), context );
+}
+
+/**
+ * Hoist invariant expressions out of a while loop, then optimize the loops inside it
+ * @param loop the while statement
+ * @param outer hoisted expressions of every loop around this one
+*/
+static void optimizeLoop( Stmt *loop, CacheList const *outer )
+{
+  NameList written = { NULL, 0, 0 };
+  collectWrites( loop, &written );
+
+  CacheList caches = { NULL, 0, 0 };
+  hoistStmt( loop, &written, &caches );
+  free( written.list );
+
+  // Throw away the saved values whenever the loop finishes.
+  if ( caches.len > 0 ) {
+    LoopExit *exit = (LoopExit *) malloc( sizeof( LoopExit ) );
+    exit->eval = evalLoopExit;
+    exit->destroy = destroyLoopExit;
+    exit->cond = *stmtExpr( loop, 0 );
+    exit->caches = copyCaches( &caches );
+    *stmtExpr( loop, 0 ) = (Expr *) exit;
+  }
+
+  // Loops nested inside this one see this loop's hoisted expressions too.
+  CacheList context = copyCaches( outer );
+  for ( int i = 0; i < caches.len; i++ )
+    addCache( &context, caches.list[ i ] );
+  free( caches.list );
+
+  visit( *stmtBody( loop, 0 ), &context );
+  free( context.list );
+}
+
+//////////////////////////////////////////////////////////////////////
+// Liveness
+
+/** Release point added by the liveness analysis, a subclass of Stmt. */
+typedef struct {
+  void (*execute)( Stmt *stmt, Environment *env );
+  void (*destroy)( Stmt *stmt );
+  int line;
+  unsigned int trace;
+
+  /** Number of dead variables. */
+  int len;
+
+  /** Names of the dead variables.  These are copies, since the statements
+      they came from are freed after they run. */
+  char **names;
+} ReleaseStmt;
+
+/** Implementation of execute for a release point. */
+static void executeRelease( Stmt *stmt, Environment *env )
+{
+  ReleaseStmt *this = (ReleaseStmt *) stmt;
+
+  // Nothing reads these variables again, so giving them an int value is
+  // the same as releasing them.
+  for ( int i = 0; i < this->len; i++ )
+    if ( lookupVariable( env, this->names[ i ] ).vtype == SeqType )
+      setVariable( env, this->names[ i ], (Value){ IntType, .ival = 0 } );
+}
+
+/** Implementation of destroy for a release point. */
+static void destroyRelease( Stmt *stmt )
+{
+  ReleaseStmt *this = (ReleaseStmt *) stmt;
+
+  for ( int i = 0; i < this->len; i++ )
+    free( this->names[ i ] );
+  free( this->names );
+  free( this );
+}
+
+/**
+ * Make a release point for the given variables
+ * @param dead names of the variables to release
+ * @param line line of the statement the release point follows
+ * @return the new statement
+*/
+static Stmt *makeRelease( NameList const *dead, int line )
+{
+  ReleaseStmt *this = (ReleaseStmt *) malloc( sizeof( ReleaseStmt ) );
+  this->execute = executeRelease;
+  this->destroy = destroyRelease;
+  this->line = line;
+  this->trace = 0;
+
+  this->len = dead->len;
+  this->names = (char **) malloc( this->len * sizeof( char * ) );
+  for ( int i = 0; i < this->len; i++ ) {
+    this->names[ i ] = (char *) malloc( strlen( dead->list[ i ] ) + 1 );
+    strcpy( this->names[ i ], dead->list[ i ] );
+  }
+
+  return (Stmt *) this;
+}
+
+/**
+ * Add the name of every variable a statement reads to a list, including sequences changed by a push or
+ * an element assignment
+ * @param stmt the statement to check
+ * @param uses the list to add to
+*/
+static void collectUses( Stmt *stmt, NameList *uses )
+{
+  for ( int i = 0; i < stmtExprCount( stmt ); i++ )
+    collectReads( *stmtExpr( stmt, i ), uses );
+
+  if ( stmtKind( stmt ) == AssignmentKind && stmtExprCount( stmt ) == 2 )
+    addName( uses, assignmentName( stmt ) );
+
+  for ( int i = 0; i < stmtBodyCount( stmt ); i++ )
+    collectUses( *stmtBody( stmt, i ), uses );
+}
+
+/** Documented in the header. */
+Stmt **releaseDeadVariables( Stmt **prog, int len, int *newLen )
+{
+  // Variables that are live after each statement, worked out backward
+  // from the end of the program.
+  NameList live = { NULL, 0, 0 };
+  NameList *dead = (NameList *) calloc( len + 1, sizeof( NameList ) );
+
+  for ( int k = len - 1; k >= 0; k-- ) {
+    NameList uses = { NULL, 0, 0 };
+    collectUses( prog[ k ], &uses );
+
+    // Only an assignment at the top level is sure to replace a value.
+    char const *def = NULL;
+    if ( stmtKind( prog[ k ] ) == AssignmentKind && stmtExprCount( prog[ k ] ) == 1 )
+      def = assignmentName( prog[ k ] );
+
+    // Variables this statement mentions that aren't live after it are dead.
+    for ( int i = 0; i < uses.len; i++ )
+      if ( !hasName( &live, uses.list[ i ] ) )
+        addName( dead + k, uses.list[ i ] );
+    if ( def && !hasName( &live, def ) )
+      addName( dead + k, def );
+
+    // Live before this statement: what it uses, plus what's live after it,
+    // unless this statement replaces the value.
+    NameList before = { NULL, 0, 0 };
+    for ( int i = 0; i < uses.len; i++ )
+      addName( &before, uses.list[ i ] );
+    for ( int i = 0; i < live.len; i++ )
+      if ( !def || strcmp( live.list[ i ], def ) != 0 )
+        addName( &before, live.list[ i ] );
+
+    free( uses.list );
+    free( live.list );
+    live = before;
+  }
+  free( live.list );
+
+  // Copy the statements into a new list, with the release points.
+  int count = len;
+  for ( int k = 0; k < len; k++ )
+    if ( dead[ k ].len > 0 )
+      count++;
+
+  Stmt **result = (Stmt **) malloc( ( count + 1 ) * sizeof( Stmt * ) );
+  *newLen = 0;
+  for ( int k = 0; k < len; k++ ) {
+    result[ ( *newLen )++ ] = prog[ k ];
+    if ( dead[ k ].len > 0 )
+      result[ ( *newLen )++ ] = makeRelease( dead + k, prog[ k ]->line );
+    free( dead[ k ].list );
+  }
+
+  free( dead );
+  free( prog );
+  return result;
+}
+
+/** Documented in the header. */
+Expr **optimizedExpr( Expr *expr )
+{
+  if ( expr->eval == evalCached )
+    return &((CachedExpr *) expr)->expr;
+  if ( expr->eval == evalLoopExit )
+    return &((LoopExit *) expr)->cond;
+  if ( expr->eval == evalInvalidator )
+    return &((Invalidator *) expr)->expr;
+  return NULL;
+}
+
+/** Documented in the header. */
+void hoistInvariants( Stmt *stmt )
+{
+  CacheList none = { NULL, 0, 0 };
+  visit( stmt, &none );
+}
@@ -0,0 +1,50 @@
+/**
+  @file optimize.h
+  @author Jake Donovan (jmpatte8)
+
+  Optimizations on parsed statements, run before a statement executes.
+  Loop-invariant code motion finds expressions in a while loop that read
+  sequences (len and indexing) through variables the loop never assigns,
+  and evaluates each of them just once per run of the loop.  A push or
+  element assignment inside the loop invalidates any saved values that
+  depend on the sequence it changes.
+
+  Liveness analysis works on a whole program.  It finds the last
+  top-level statement that uses each variable, and adds a statement
+  after it that releases the sequence the variable holds, so memory is
+  freed as soon as a variable is dead rather than when the program ends.
+*/
+
+#ifndef _OPTIMIZE_H_
+#define _OPTIMIZE_H_
+
+#include "syntax.h"
+
+/** Hoist loop-invariant expressions out of every while loop in the given
+    statement, including the statement itself.  The statement is changed
+    in place and behaves exactly as before, including any errors.
+    @param stmt statement to optimize.
+ */
+void hoistInvariants( Stmt *stmt );
+
+/** Insert release points into a whole program, releasing the sequence
+    held in each variable right after the top-level statement that uses
+    the variable for the last time.  A variable that's assigned a new
+    value before it's used again is also released in between.
+    @param prog the program's top-level statements, in order.  This list
+    is freed, and its statements are moved to the new one.
+    @param len number of statements in prog.
+    @param newLen returns the number of statements in the new list.
+    @return new, dynamically allocated list of statements to run.
+ */
+Stmt **releaseDeadVariables( Stmt **prog, int len, int *newLen );
+
+/** Return the address of the expression inside one of the wrappers this
+    optimization adds to a program, so other passes can work on it.
+    @param expr expression to check.
+    @return address of the pointer to the wrapped expression, or NULL if
+    expr isn't one of our wrappers.
+ */
+Expr **optimizedExpr( Expr *expr );
+
+#endif
@@ -5,6 +5,8 @@
 */
 
 #include "parse.h"
+#include "runtime.h"
+#include "trace.h"
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
@@ -22,14 +24,15 @@ static Expr *parseExpr( char *tok, FILE *fp );
 //////////////////////////////////////////////////////////////////////
 // Input tokenization
 
-// Current line we're parsing, starting from 1 like most editors.
-static int lineCount = 1;
+// Current line we're parsing, starting from 1 like most editors.  Each
+// thread parses its own program, so each one gets its own count.
+static __thread int lineCount = 1;
 
 /** Print a syntax error message, with a line number and exit. */
 static void syntaxError()
 {
-  fprintf( stderr, "line %d: syntax error\n", lineCount );
-  exit( EXIT_FAILURE );
+  fprintf( programErrors(), "line %d: syntax error\n", lineCount );
+  programExit();
 }
 
 /** Helper function for parseToken.  It checks for overflow and stores
@@ -41,8 +44,8 @@ static void addToToken( char ch, char *token, int *len )
 {
   // Complain if the token is too long.
   if ( *len >= MAX_TOKEN ) {
-    fprintf( stderr, "line %d: token too long\n", lineCount );
-    exit( EXIT_FAILURE );
+    fprintf( programErrors(), "line %d: token too long\n", lineCount );
+    programExit();
   }
 
   // Add the given character.
@@ -51,11 +54,30 @@ static void addToToken( char ch, char *token, int *len )
 }
 
 /** Documented in the header. */
-bool parseToken( char *token, FILE *fp )
+void resetParser()
+{
+  lineCount = 1;
+}
+
+/** Documented in the header. */
+void skipLine( FILE *fp )
+{
+  int ch = getc( fp );
+  while ( ch != EOF && ch != '\n' )
+    ch = getc( fp );
+  if ( ch == '\n' )
+    lineCount++;
+}
+
+/** Skip whitespace and comments, then look at the next character
+    without reading it.
+    @param fp file tokens are being read from.
+    @return the next character, still on the input, or EOF.
+*/
+static int peekChar( FILE *fp )
 {
   int ch;
 
-  // Skip whitespace and comments.
   while ( isspace( ch = fgetc( fp ) ) || ch == '#' ) {
     // If we hit the comment characer, skip the whole line.
     if ( ch == '#' )
@@ -65,7 +87,19 @@ bool parseToken( char *token, FILE *fp )
     if ( ch == '\n' )
       lineCount++;
   }
-    
+
+  if ( ch != EOF )
+    ungetc( ch, fp );
+  return ch;
+}
+
+/** Documented in the header. */
+bool parseToken( char *token, FILE *fp )
+{
+  // Skip whitespace and comments.
+  peekChar( fp );
+  int ch = fgetc( fp );
+
   if ( ch == EOF )
     return false;
 
@@ -104,8 +138,8 @@ bool parseToken( char *token, FILE *fp )
     while ( ( ch = fgetc( fp ) ) != quote || escape ) {
       // Error conditions
       if ( ch == EOF || ch == '\n' ) {
-        fprintf( stderr, "line %d: invalid string literal.\n", lineCount );
-        exit( EXIT_FAILURE );
+        fprintf( programErrors(), "line %d: invalid string literal.\n", lineCount );
+        programExit();
       }
       
       // On a backslash, we just enable escape mode.
@@ -128,9 +162,9 @@ bool parseToken( char *token, FILE *fp )
             ch = '\\';
             break;
           default:
-            fprintf( stderr, "line %d: Invalid escape sequence \"\\%c\"\n",
+            fprintf( programErrors(), "line %d: Invalid escape sequence \"\\%c\"\n",
                      lineCount, ch );
-            exit( EXIT_FAILURE );
+            programExit();
           }
           escape = false;
         }
@@ -143,8 +177,8 @@ bool parseToken( char *token, FILE *fp )
 
     // Single-quoted strings must be exactly one character long.
     if ( quote == '\'' && len != SINGLE_QUOTE_LENGTH  + 1 + 1 ) {
-      fprintf( stderr, "line %d: Invalid single-quoted string\n", lineCount );
-      exit( EXIT_FAILURE );
+      fprintf( programErrors(), "line %d: Invalid single-quoted string\n", lineCount );
+      programExit();
     }
   }  else {
     // Is this a multi-character token?
@@ -259,6 +293,25 @@ static Expr *parseTerm( char tok[ MAX_TOKEN + 1 ], FILE *fp )
     return makeLenExpr( expr );
   }
 
+  // Builtins that take their arguments in parentheses.  They're only
+  // builtins when a parenthesis follows, so older programs can still use
+  // sort and find as variable names.
+  if ( strcmp( tok, "sort" ) == 0 && peekChar( fp ) == '(' ) {
+    requireToken( "(", fp );
+    Expr *expr = parseExpr( expectToken( tok, fp ), fp );
+    requireToken( ")", fp );
+    return makeSortExpr( expr );
+  }
+
+  if ( strcmp( tok, "find" ) == 0 && peekChar( fp ) == '(' ) {
+    requireToken( "(", fp );
+    Expr *seq = parseExpr( expectToken( tok, fp ), fp );
+    requireToken( ",", fp );
+    Expr *sub = parseExpr( expectToken( tok, fp ), fp );
+    requireToken( ")", fp );
+    return makeFindExpr( seq, sub );
+  }
+
   if(strcmp(tok, "[") == 0){
     if(strcmp(expectToken(tok, fp), "]") == 0){
        return makeSequenceInitializer(0, NULL);
@@ -285,7 +338,10 @@ static Expr *parseTerm( char tok[ MAX_TOKEN + 1 ], FILE *fp )
         expectToken(tok, fp);
       }
 
-      return makeSequenceInitializer( len, list );
+      // The initializer makes its own copy of the list.
+      Expr *init = makeSequenceInitializer( len, list );
+      free( list );
+      return init;
     }
   }
 
@@ -379,12 +435,13 @@ static Expr *parseExpr( char *tok, FILE *fp )
 }
 
 /**
- * Parse each statement read in to this file
+ * Parse each statement read in to this file, the same as parseStmt() but without filling in the line
+ * number
  * @param tok a char pointer we want to examine
  * @param fp the file we are reading from
  * @return a statement
 */
-Stmt *parseStmt( char *tok, FILE *fp )
+static Stmt *parseStatement( char *tok, FILE *fp )
 {
   // Handle compound statements
   if ( strcmp( tok, "{" ) == 0 ) {
@@ -480,3 +537,14 @@ Stmt *parseStmt( char *tok, FILE *fp )
   // Never reached.
   return NULL;
 }
+
+/** Documented in the header. */
+Stmt *parseStmt( char *tok, FILE *fp )
+{
+  // Remember where the statement starts, for tracing.
+  int line = lineCount;
+  Stmt *stmt = parseStatement( tok, fp );
+  stmt->line = line;
+  stmt->trace = traceTag( line, stmtKind( stmt ) );
+  return stmt;
+}
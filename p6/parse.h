@@ -20,6 +20,11 @@
 /** Maximum length of a token in the source file. */
 #define MAX_TOKEN 1023
 
+/** Get ready to parse a new program on this thread, starting over at
+    line 1 for error messages.
+*/
+void resetParser();
+
 /** Read the next token from the given file, skipping whitespace or comments.
     @param tok storage for the token, with room for a string of up to
      MAX_TOKEN characters.
@@ -28,6 +33,12 @@
 */
 bool parseToken( char token[], FILE *fp );
 
+/** Discard the rest of the current line of input, after a syntax
+    error, so parsing can start over on the next line.
+    @param fp file tokens are being read from.
+*/
+void skipLine( FILE *fp );
+
 /** Parse with one token worth of look-ahead, return the Stmt
     object representing the next legal statement from the input.
     @param tok next token from the input, already read before
@@ -0,0 +1,161 @@
+/**
+ * @file pool.c
+ * @author Jake Donovan (jmpatte8)
+ * Size-class pool allocator with thread-local free lists.  Free blocks are linked together through
+ * their first few bytes, so the free lists need no memory of their own.
+*/
+
+#include "pool.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+/** Number of size classes, one for each power of two from POOL_MIN_BLOCK
+    up to POOL_MAX_BLOCK. */
+#define CLASSES 7
+
+/** A free block, linked into the free list for its size class. */
+typedef struct FreeBlockStruct {
+  struct FreeBlockStruct *next;
+} FreeBlock;
+
+/** Allocation counts for one size class. */
+typedef struct {
+  /** Allocations served from a free list. */
+  long hits;
+  /** Allocations that had to go to malloc. */
+  long misses;
+} ClassStats;
+
+/** Free list for each size class, for this thread. */
+static __thread FreeBlock *freeList[ CLASSES ];
+
+/** Number of blocks on each of this thread's free lists. */
+static __thread int freeCount[ CLASSES ];
+
+/** Counts for this thread, not yet added to the totals. */
+static __thread ClassStats threadStats[ CLASSES ];
+
+/** Counts for the whole process, from threads that have flushed. */
+static ClassStats totalStats[ CLASSES ];
+
+/** Lock protecting totalStats. */
+static pthread_mutex_t statsLock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Find the size class for a request
+ * @param size number of bytes requested
+ * @return index of the size class, or -1 if it's too big for the pool
+*/
+static int sizeClass( size_t size )
+{
+  if ( size > POOL_MAX_BLOCK )
+    return -1;
+  if ( size <= POOL_MIN_BLOCK )
+    return 0;
+
+  // Number of bits needed for size - 1, less the bits for POOL_MIN_BLOCK.
+  return 8 * sizeof( long ) - __builtin_clzl( size - 1 ) - 3;
+}
+
+/** Documented in the header. */
+size_t poolBlockSize( size_t size )
+{
+  int c = sizeClass( size );
+  return c < 0 ? size : (size_t) POOL_MIN_BLOCK << c;
+}
+
+/** Documented in the header. */
+void *poolAlloc( size_t size )
+{
+  int c = sizeClass( size );
+  if ( c < 0 )
+    return malloc( size );
+
+  FreeBlock *block = freeList[ c ];
+  if ( block ) {
+    freeList[ c ] = block->next;
+    freeCount[ c ]--;
+    threadStats[ c ].hits++;
+    return block;
+  }
+
+  threadStats[ c ].misses++;
+  return malloc( (size_t) POOL_MIN_BLOCK << c );
+}
+
+/** Documented in the header. */
+void poolFree( void *ptr, size_t size )
+{
+  int c = sizeClass( size );
+  if ( c < 0 || freeCount[ c ] >= POOL_LIMIT ) {
+    free( ptr );
+    return;
+  }
+
+  FreeBlock *block = (FreeBlock *) ptr;
+  block->next = freeList[ c ];
+  freeList[ c ] = block;
+  freeCount[ c ]++;
+}
+
+/** Documented in the header. */
+void *poolRealloc( void *ptr, size_t oldSize, size_t newSize )
+{
+  int oldClass = sizeClass( oldSize );
+  int newClass = sizeClass( newSize );
+
+  // Still fits in the same block.
+  if ( oldClass >= 0 && oldClass == newClass )
+    return ptr;
+
+  // Too big for the pool, before and after.
+  if ( oldClass < 0 && newClass < 0 )
+    return realloc( ptr, newSize );
+
+  void *block = poolAlloc( newSize );
+  memcpy( block, ptr, oldSize < newSize ? oldSize : newSize );
+  poolFree( ptr, oldSize );
+  return block;
+}
+
+/** Documented in the header. */
+void poolFlush()
+{
+  for ( int c = 0; c < CLASSES; c++ ) {
+    while ( freeList[ c ] ) {
+      FreeBlock *block = freeList[ c ];
+      freeList[ c ] = block->next;
+      free( block );
+    }
+    freeCount[ c ] = 0;
+  }
+
+  pthread_mutex_lock( &statsLock );
+  for ( int c = 0; c < CLASSES; c++ ) {
+    totalStats[ c ].hits += threadStats[ c ].hits;
+    totalStats[ c ].misses += threadStats[ c ].misses;
+    threadStats[ c ] = (ClassStats){ 0, 0 };
+  }
+  pthread_mutex_unlock( &statsLock );
+}
+
+/** Documented in the header. */
+void poolReport( FILE *fp )
+{
+  long hits = 0, allocs = 0;
+
+  pthread_mutex_lock( &statsLock );
+  fprintf( fp, "%10s %12s %12s %9s\n", "block", "allocs", "hits", "hit rate" );
+  for ( int c = 0; c < CLASSES; c++ ) {
+    long n = totalStats[ c ].hits + totalStats[ c ].misses;
+    fprintf( fp, "%10d %12ld %12ld %8.1f%%\n", POOL_MIN_BLOCK << c, n,
+             totalStats[ c ].hits, n ? 100.0 * totalStats[ c ].hits / n : 0.0 );
+    hits += totalStats[ c ].hits;
+    allocs += n;
+  }
+  pthread_mutex_unlock( &statsLock );
+
+  fprintf( fp, "%10s %12ld %12ld %8.1f%%\n", "total", allocs, hits,
+           allocs ? 100.0 * hits / allocs : 0.0 );
+}
@@ -0,0 +1,69 @@
+/**
+  @file pool.h
+  @author Jake Donovan (jmpatte8)
+
+  Pooled allocator for sequence headers and small element buffers.
+  Small blocks are rounded up to one of a few size classes, and freed
+  blocks go on a free list for their class instead of back to malloc.
+  Free lists are kept per thread, so threads never contend for them.
+  The pool also counts how often allocations are served from a free
+  list, so its hit rate can be reported.
+*/
+
+#ifndef _POOL_H_
+#define _POOL_H_
+
+#include <stdio.h>
+#include <stddef.h>
+
+/** Smallest block size the pool hands out. */
+#define POOL_MIN_BLOCK 8
+
+/** Largest block size the pool keeps free lists for.  Bigger requests go
+    right to malloc. */
+#define POOL_MAX_BLOCK 512
+
+/** Most free blocks a thread keeps for each size class.  Anything freed
+    past this goes back to malloc. */
+#define POOL_LIMIT 1024
+
+/** Return the number of bytes actually available in a block of the given
+    size, so callers can make use of the rounding.
+    @param size number of bytes requested.
+    @return usable size of a block allocated for that request.
+ */
+size_t poolBlockSize( size_t size );
+
+/** Allocate a block of memory.
+    @param size number of bytes needed.
+    @return pointer to the new block.
+ */
+void *poolAlloc( size_t size );
+
+/** Free a block from poolAlloc().
+    @param ptr the block to free.
+    @param size the size it was allocated with.
+ */
+void poolFree( void *ptr, size_t size );
+
+/** Resize a block from poolAlloc(), keeping its contents.
+    @param ptr the block to resize.
+    @param oldSize the size it was allocated with.
+    @param newSize the size needed now.
+    @return pointer to the resized block, which may have moved.
+ */
+void *poolRealloc( void *ptr, size_t oldSize, size_t newSize );
+
+/** Give back every free block cached by the calling thread, and add its
+    counts to the totals for the process.  Threads should call this
+    before they exit.
+ */
+void poolFlush();
+
+/** Print allocation counts and hit rates for each size class, for every
+    thread that's called poolFlush() so far.
+    @param fp stream to print to.
+ */
+void poolReport( FILE *fp );
+
+#endif
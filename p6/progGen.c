@@ -0,0 +1,297 @@
+/**
+ * @file progGen.c
+ * @author Jake Donovan (jmpatte8)
+ * Generates random, syntactically valid programs for the interpreter, for differential testing of
+ * the execution engines.  The same seed always produces the same program.  Every loop is bounded,
+ * so generated programs always terminate, although some of them stop with a runtime error like
+ * division by zero or a type mismatch.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+/** Number of int variables used by generated programs. */
+#define INT_VARS 5
+
+/** Number of sequence variables used by generated programs. */
+#define SEQ_VARS 3
+
+/** Every sequence starts with at least this many elements, so indexes
+    below this are always in bounds. */
+#define MIN_SEQ_LEN 3
+
+/** Deepest nesting of loops and if statements. */
+#define MAX_NESTING 3
+
+/** Deepest nesting of expressions. */
+#define MAX_EXPR_DEPTH 3
+
+/** Most iterations for a generated loop. */
+#define MAX_ITERATIONS 12
+
+/** Number of statements at the top level of a program. */
+#define TOP_STATEMENTS 25
+
+/** Current state of the random number generator. */
+static unsigned long long rngState;
+
+/**
+ * Return the next pseudo-random number, from a simple 64-bit LCG so the sequence is the same everywhere
+ * @param n upper bound for the result
+ * @return a value from 0 up to n - 1
+*/
+static int rnd( int n )
+{
+  rngState = rngState * 6364136223846793005ULL + 1442695040888963407ULL;
+  return (int)( ( rngState >> 33 ) % n );
+}
+
+/**
+ * Print indentation for the given nesting level
+ * @param level how deeply the statement is nested
+*/
+static void indent( int level )
+{
+  for ( int i = 0; i < level; i++ )
+    printf( "  " );
+}
+
+// Prototype, so int and sequence expressions can contain each other.
+static void seqExpr( int depth );
+
+/**
+ * Print a random expression that should evaluate to an int
+ * @param depth how much deeper the expression is allowed to go
+*/
+static void intExpr( int depth )
+{
+  int choice = depth <= 0 ? rnd( 3 ) : rnd( 12 );
+
+  switch ( choice ) {
+  case 0:
+    printf( "%d", rnd( 41 ) - 10 );
+    break;
+  case 1:
+  case 2:
+    printf( "x%d", rnd( INT_VARS ) );
+    break;
+  case 3:
+  case 4:
+  case 5: {
+    static char const *ops[] = { "+", "-", "*", "<", "==", "&&", "||" };
+    printf( "( " );
+    intExpr( depth - 1 );
+    printf( " %s ", ops[ rnd( 7 ) ] );
+    intExpr( depth - 1 );
+    printf( " )" );
+    break;
+  }
+  case 6:
+    // Usually divide by a non-zero literal, but sometimes risk a zero.
+    printf( "( " );
+    intExpr( depth - 1 );
+    printf( " / " );
+    if ( rnd( 20 ) )
+      printf( "%d", rnd( 9 ) + 1 );
+    else
+      intExpr( depth - 1 );
+    printf( " )" );
+    break;
+  case 7:
+    printf( "( len " );
+    seqExpr( depth - 1 );
+    printf( " )" );
+    break;
+  case 8:
+    // Parenthesized, since indexing applies to everything to its left.
+    printf( "( s%d[ %d ] )", rnd( SEQ_VARS ), rnd( MIN_SEQ_LEN ) );
+    break;
+  case 9:
+    // Compare two sequences, or search one for the other.
+    if ( rnd( 3 ) ) {
+      printf( "( " );
+      seqExpr( depth - 1 );
+      printf( rnd( 2 ) ? " < " : " == " );
+    } else {
+      printf( "find( " );
+      seqExpr( depth - 1 );
+      printf( ", " );
+    }
+    seqExpr( depth - 1 );
+    printf( " )" );
+    break;
+  case 10:
+    printf( "'%c'", 'a' + rnd( 26 ) );
+    break;
+  default:
+    // Once in a while, use a sequence where an int is expected.
+    if ( rnd( 100 ) == 0 )
+      seqExpr( depth - 1 );
+    else
+      printf( "x%d", rnd( INT_VARS ) );
+    break;
+  }
+}
+
+/**
+ * Print a random expression that should evaluate to a sequence
+ * @param depth how much deeper the expression is allowed to go
+*/
+static void seqExpr( int depth )
+{
+  int choice = rnd( 4 );
+
+  if ( choice == 0 ) {
+    // A short string literal.
+    printf( "\"" );
+    int len = rnd( 5 );
+    for ( int i = 0; i < len; i++ )
+      printf( "%c", 'a' + rnd( 26 ) );
+    printf( "\"" );
+  } else if ( choice == 1 && depth > 0 ) {
+    // A list of int expressions.
+    int len = rnd( 4 );
+    printf( "[" );
+    for ( int i = 0; i < len; i++ ) {
+      printf( i ? ", " : " " );
+      intExpr( depth - 1 );
+    }
+    printf( " ]" );
+  } else if ( choice == 2 && depth > 0 && rnd( 2 ) ) {
+    printf( "sort( " );
+    seqExpr( depth - 1 );
+    printf( " )" );
+  } else {
+    printf( "s%d", rnd( SEQ_VARS ) );
+  }
+}
+
+// Prototype, so statements can contain other statements.
+static void statement( int level );
+
+/**
+ * Print a compound statement with a few random statements in it
+ * @param level nesting level of the statements inside
+ * @param extra additional statement to put at the end of the body, or NULL
+*/
+static void block( int level, char const *extra )
+{
+  printf( "{\n" );
+
+  int len = rnd( 4 ) + 1;
+  for ( int i = 0; i < len; i++ )
+    statement( level );
+
+  if ( extra ) {
+    indent( level );
+    printf( "%s\n", extra );
+  }
+
+  indent( level - 1 );
+  printf( "}\n" );
+}
+
+/**
+ * Print a random statement
+ * @param level nesting level, which also picks the loop counter for a while loop
+*/
+static void statement( int level )
+{
+  int choice = rnd( level < MAX_NESTING ? 11 : 8 );
+
+  indent( level );
+  switch ( choice ) {
+  case 0:
+  case 1:
+  case 2:
+    printf( "x%d = ", rnd( INT_VARS ) );
+    intExpr( MAX_EXPR_DEPTH );
+    printf( ";\n" );
+    break;
+  case 3:
+    printf( "print " );
+    intExpr( MAX_EXPR_DEPTH );
+    printf( ";\n" );
+    break;
+  case 4:
+    // Print a sequence, or a separator between values.
+    if ( rnd( 2 ) )
+      printf( "print s%d;\n", rnd( SEQ_VARS ) );
+    else
+      printf( "print \"%s\";\n", rnd( 2 ) ? " " : "\\n" );
+    break;
+  case 5:
+    printf( "push s%d, ", rnd( SEQ_VARS ) );
+    intExpr( MAX_EXPR_DEPTH - 1 );
+    printf( ";\n" );
+    break;
+  case 6:
+    printf( "s%d[ %d ] = ", rnd( SEQ_VARS ), rnd( MIN_SEQ_LEN ) );
+    intExpr( MAX_EXPR_DEPTH - 1 );
+    printf( ";\n" );
+    break;
+  case 7:
+    // Make one sequence variable refer to another, or to a new sequence,
+    // keeping every sequence at least MIN_SEQ_LEN long.
+    if ( rnd( 2 ) )
+      printf( "s%d = s%d;\n", rnd( SEQ_VARS ), rnd( SEQ_VARS ) );
+    else
+      printf( "s%d = [ %d, %d, %d ];\n", rnd( SEQ_VARS ), rnd( 200 ),
+              rnd( 200 ), rnd( 200 ) );
+    break;
+  case 8:
+  case 9:
+    printf( "if ( " );
+    intExpr( MAX_EXPR_DEPTH );
+    printf( " ) " );
+    if ( rnd( 2 ) )
+      block( level + 1, NULL );
+    else {
+      printf( "\n" );
+      statement( level + 1 );
+    }
+    break;
+  default: {
+    // A loop with its own counter, which nothing else assigns to.
+    char step[ 40 ];
+    sprintf( step, "i%d = i%d + 1;", level, level );
+    printf( "i%d = 0;\n", level );
+    indent( level );
+    printf( "while ( i%d < %d ) ", level, rnd( MAX_ITERATIONS ) );
+    block( level + 1, step );
+    break;
+  }
+  }
+}
+
+/**
+ * Program starting point, prints one random program for the seed given on the command line
+ * @param argc the number of command line arguments
+ * @param argv an array of char pointers which point to each command line argument
+ * @return program exit status
+*/
+int main( int argc, char *argv[] )
+{
+  if ( argc != 2 || sscanf( argv[ 1 ], "%llu", &rngState ) != 1 ) {
+    fprintf( stderr, "usage: progGen <seed>\n" );
+    exit( EXIT_FAILURE );
+  }
+
+  printf( "# Generated by progGen %s\n", argv[ 1 ] );
+
+  // Give every variable a value before we start.
+  for ( int i = 0; i < INT_VARS; i++ )
+    printf( "x%d = %d;\n", i, rnd( 21 ) - 5 );
+  for ( int i = 0; i < SEQ_VARS; i++ )
+    if ( rnd( 2 ) )
+      printf( "s%d = \"str%c\";\n", i, 'a' + rnd( 26 ) );
+    else
+      printf( "s%d = [ %d, %d, %d ];\n", i, rnd( 1000 ), rnd( 300 ),
+              rnd( 100 ) );
+
+  for ( int i = 0; i < TOP_STATEMENTS; i++ )
+    statement( 0 );
+
+  return EXIT_SUCCESS;
+}
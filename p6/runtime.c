@@ -0,0 +1,165 @@
+/**
+ * @file runtime.c
+ * @author Jake Donovan (jmpatte8)
+ * Keeps track of the output streams and error recovery point for the program running on each thread,
+ * so several programs can be run in the same process.  Also keeps each program's statement count, for
+ * statement budgets and time slicing
+*/
+
+#include "runtime.h"
+#include "trace.h"
+#include <stdlib.h>
+#include <limits.h>
+
+/** Stream for print statements on this thread, or NULL for stdout. */
+static __thread FILE *outStream = NULL;
+
+/** Stream for error messages on this thread, or NULL for stderr. */
+static __thread FILE *errStream = NULL;
+
+/** Where to go on an error, or NULL to exit the process. */
+static __thread jmp_buf *recovery = NULL;
+
+/** Documented in the header. */
+FILE *programOutput()
+{
+  return outStream ? outStream : stdout;
+}
+
+/** Documented in the header. */
+FILE *programErrors()
+{
+  return errStream ? errStream : stderr;
+}
+
+/** Documented in the header. */
+void setProgramStreams( FILE *out, FILE *err )
+{
+  outStream = out;
+  errStream = err;
+}
+
+/** Documented in the header. */
+void setRecoveryPoint( jmp_buf *env )
+{
+  recovery = env;
+}
+
+/** Documented in the header. */
+void programExit()
+{
+  // Leave a record of what the program was doing.
+  traceError( programErrors() );
+
+  if ( recovery )
+    longjmp( *recovery, 1 );
+
+  exit( EXIT_FAILURE );
+}
+
+/** Documented in the header. */
+__thread unsigned long programSteps = 0;
+
+/** Documented in the header. */
+__thread unsigned long programLimit = ULONG_MAX;
+
+/** Statement count where the current program's budget runs out. */
+static __thread unsigned long budgetEnd = ULONG_MAX;
+
+/** Statements in a time slice, or zero if this thread doesn't slice. */
+static __thread unsigned long sliceSteps = 0;
+
+/** Function to call at the end of a time slice. */
+static __thread void (*yieldFunction)() = NULL;
+
+/** Everything this file keeps for the current program, saved while the
+    program is paused so another one can use the thread. */
+typedef struct {
+  FILE *out;
+  FILE *err;
+  jmp_buf *recovery;
+  unsigned long steps;
+  unsigned long budgetEnd;
+  TraceRing trace;
+} ProgramState;
+
+/**
+ * Work out the next statement count where checkBudget() has to do something, either the end of the
+ * budget or the end of the current time slice
+*/
+static void updateLimit()
+{
+  programLimit = budgetEnd;
+  if ( sliceSteps && programSteps + sliceSteps < programLimit )
+    programLimit = programSteps + sliceSteps;
+}
+
+/**
+ * Save the state of the current program.  This and restoreState() aren't inlined, so thread-local
+ * variables are looked up fresh on whatever thread the program is running on.  With tracing on, the
+ * program's trace goes with it, so it isn't mixed up with the programs that run while it's paused
+ * @param state where to save the state
+*/
+static __attribute__(( noinline )) void saveState( ProgramState *state )
+{
+  state->out = outStream;
+  state->err = errStream;
+  state->recovery = recovery;
+  state->steps = programSteps;
+  state->budgetEnd = budgetEnd;
+  if ( traceEnabled )
+    state->trace = traceRing;
+}
+
+/**
+ * Put back the state of a program that's resuming, and start its next time slice
+ * @param state the state saved when the program paused
+*/
+static __attribute__(( noinline )) void restoreState( ProgramState const *state )
+{
+  outStream = state->out;
+  errStream = state->err;
+  recovery = state->recovery;
+  programSteps = state->steps;
+  budgetEnd = state->budgetEnd;
+  if ( traceEnabled )
+    traceRing = state->trace;
+  updateLimit();
+}
+
+/** Documented in the header. */
+void budgetExhausted()
+{
+  if ( programSteps >= budgetEnd ) {
+    fprintf( programErrors(), "Statement budget exceeded\n" );
+    programExit();
+  }
+
+  // Otherwise, the time slice is over.
+  ProgramState state;
+  saveState( &state );
+  yieldFunction();
+  restoreState( &state );
+}
+
+/** Documented in the header. */
+bool budgetActive()
+{
+  return programLimit != ULONG_MAX;
+}
+
+/** Documented in the header. */
+void setStatementBudget( unsigned long budget )
+{
+  programSteps = 0;
+  budgetEnd = budget ? budget : ULONG_MAX;
+  updateLimit();
+}
+
+/** Documented in the header. */
+void setTimeSlice( unsigned long slice, void (*yield)() )
+{
+  sliceSteps = slice;
+  yieldFunction = yield;
+  updateLimit();
+}
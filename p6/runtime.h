@@ -0,0 +1,106 @@
+/**
+  @file runtime.h
+  @author Jake Donovan (jmpatte8)
+
+  Per-thread state for the program currently being run, where its
+  output goes and what happens when it hits an error.  By default,
+  output goes to stdout, errors go to stderr and an error exits the
+  process, just like a standalone run of the interpreter.
+
+  The runtime also counts the statements a program executes.  Loops
+  check the count at the end of every iteration, so a program can be
+  stopped once it uses up its statement budget, or paused at the end of
+  a time slice so another program gets a turn on the same thread.
+*/
+
+#ifndef _RUNTIME_H_
+#define _RUNTIME_H_
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <setjmp.h>
+
+/** Return the stream print statements should write to on this thread.
+    @return output stream for the current program.
+*/
+FILE *programOutput();
+
+/** Return the stream error messages should be written to on this thread.
+    @return error stream for the current program.
+*/
+FILE *programErrors();
+
+/** Redirect output and error messages for programs run on this thread.
+    Passing NULL for either one restores the default (stdout or stderr).
+    @param out stream for output from print statements.
+    @param err stream for error messages.
+*/
+void setProgramStreams( FILE *out, FILE *err );
+
+/** Arm (or, with NULL, disarm) a recovery point for this thread.  While
+    it's armed, programExit() jumps back to the given buffer instead of
+    exiting the process.
+    @param env buffer previously filled in by setjmp().
+*/
+void setRecoveryPoint( jmp_buf *env );
+
+/** Stop running the current program after an error message has been
+    reported.  This dumps the trace for this thread, if tracing is on,
+    then exits unsuccessfully, unless a recovery point is armed on
+    this thread.
+*/
+void programExit();
+
+/** Number of statements the program on this thread has executed. */
+extern __thread unsigned long programSteps;
+
+/** Statement count where the program on this thread has to stop or
+    pause, checked by checkBudget(). */
+extern __thread unsigned long programLimit;
+
+/** Count one executed statement. */
+static inline __attribute__(( always_inline )) void countStatement()
+{
+  programSteps++;
+}
+
+/** Called when programSteps reaches programLimit.  This stops the
+    program with an error if it's used up its budget, or pauses it if
+    its time slice is over.
+*/
+void budgetExhausted();
+
+/** Check whether the program on this thread has run out of statements,
+    at the end of a loop iteration.  Loops are the only way a program
+    can run for long, so this is enough to bound how long it runs.
+*/
+static inline __attribute__(( always_inline )) void checkBudget()
+{
+  if ( programSteps >= programLimit )
+    budgetExhausted();
+}
+
+/** Report whether the program on this thread has a budget or a time
+    slice, so code that skips checkBudget() (like native loops) knows it
+    shouldn't run.
+    @return true if checkBudget() could ever stop or pause the program.
+*/
+bool budgetActive();
+
+/** Start counting statements for a new program on this thread.
+    @param budget number of statements the program can execute before
+    it's stopped with an error, or zero for no limit.
+*/
+void setStatementBudget( unsigned long budget );
+
+/** Set up time slicing for programs run on this thread.  Once a
+    program executes the given number of statements, the yield function
+    is called to let other programs run.  When it returns, the program
+    picks up where it left off, possibly on a different thread.
+    @param slice statements in each time slice, or zero to turn time
+    slicing off.
+    @param yield function to call at the end of each slice.
+*/
+void setTimeSlice( unsigned long slice, void (*yield)() );
+
+#endif
@@ -6,6 +6,8 @@
 */
 
 #include "syntax.h"
+#include "runtime.h"
+#include "trace.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -16,26 +18,19 @@
 /** Report an error for a program with bad types, then exit. */
 static int reportTypeMismatch()
 {
-  fprintf( stderr, "Type mismatch\n" );
-  exit( EXIT_FAILURE );
+  fprintf( programErrors(), "Type mismatch\n" );
+  programExit();
 }
 
-/** Require a given value to be an IntType value.  Exit with an error
-    message if not.
-    @param v value to check, passed by address.
- */
-static void requireIntType( Value const *v )
+/** Documented in the header. */
+void requireIntType( Value const *v )
 {
   if ( v->vtype != IntType )
     reportTypeMismatch();
 }
 
-/**
- * This function is responsible for checking a passed value to verify that it is a sequence, 
- * exits unsucessfully if the value is not a sequence
- * @param v the value we want to examine
-*/
-static void requireSequence( Value const *v ){
+/** Documented in the header. */
+void requireSequence( Value const *v ){
   if(v->vtype != SeqType)
     reportTypeMismatch();
 }
@@ -177,24 +172,44 @@ Expr *makeAdd( Expr *left, Expr *right )
   return buildSimpleExpr( left, right, evalAdd );
 }
 
-/** Implementation of evalLen to evaluate the length of a passed expression if it is a sequence */
-static Value evalLen(Expr *expr, Environment *env) {
-  SimpleExpr *this = (SimpleExpr *)expr;
-
-  // evaluate a sequence 
-  Value v = this->expr1->eval(this->expr1, env);
+/**
+ * Free a value if it's a temporary sequence, one that no variable refers to, once an operator is
+ * done with it
+ * @param v the operand value
+*/
+static void releaseTemporary( Value v )
+{
+  if ( v.vtype == SeqType && v.sval->ref == 0 )
+    freeSequence( v.sval );
+}
 
+/** Documented in the header. */
+Value applyLen( Value v )
+{
   // require a sequence
   requireSequence(&v);
 
   // grab sequence
   grabSequence(v.sval);
 
+  // get the sequence's length aka number of elements in the sequence before
+  // releasing it, since a temporary sequence is freed by the release
+  int len = v.sval->len;
+
   // release sequence
   releaseSequence(v.sval);
 
-  // return the sequence's length aka number of elements in the sequence
-  return (Value){ IntType, v.sval->len };
+  return (Value){ IntType, len };
+}
+
+/** Implementation of evalLen to evaluate the length of a passed expression if it is a sequence */
+static Value evalLen(Expr *expr, Environment *env) {
+  SimpleExpr *this = (SimpleExpr *)expr;
+
+  // evaluate a sequence 
+  Value v = this->expr1->eval(this->expr1, env);
+
+  return applyLen( v );
 }
 
 /** Implementation of makeLenExpr to construct a new len expr by creating expr as a SimpleExpr */
@@ -202,6 +217,62 @@ Expr *makeLenExpr( Expr *expr ){
   return buildSimpleExpr(expr, NULL, evalLen);
 }
 
+/** Documented in the header. */
+Value applySort( Value v )
+{
+  requireSequence( &v );
+
+  Sequence *sorted = sortSequence( v.sval );
+  releaseTemporary( v );
+
+  return (Value){ SeqType, .sval = sorted };
+}
+
+/** Implementation of eval for the sort builtin */
+static Value evalSort( Expr *expr, Environment *env )
+{
+  SimpleExpr *this = (SimpleExpr *)expr;
+
+  return applySort( this->expr1->eval( this->expr1, env ) );
+}
+
+/** Implementation of makeSortExpr to construct a new sort expression as a SimpleExpr */
+Expr *makeSortExpr( Expr *expr )
+{
+  return buildSimpleExpr( expr, NULL, evalSort );
+}
+
+/** Documented in the header. */
+Value applyFind( Value seq, Value sub )
+{
+  requireSequence( &seq );
+  requireSequence( &sub );
+
+  int idx = findSequence( seq.sval, sub.sval );
+
+  releaseTemporary( seq );
+  releaseTemporary( sub );
+
+  return (Value){ IntType, .ival = idx };
+}
+
+/** Implementation of eval for the find builtin */
+static Value evalFind( Expr *expr, Environment *env )
+{
+  SimpleExpr *this = (SimpleExpr *)expr;
+
+  Value seq = this->expr1->eval( this->expr1, env );
+  Value sub = this->expr2->eval( this->expr2, env );
+
+  return applyFind( seq, sub );
+}
+
+/** Implementation of makeFindExpr to construct a new find expression as a SimpleExpr */
+Expr *makeFindExpr( Expr *seq, Expr *sub )
+{
+  return buildSimpleExpr( seq, sub, evalFind );
+}
+
 //////////////////////////////////////////////////////////////////////
 // Integer subtracton
 
@@ -261,30 +332,36 @@ Expr *makeMul( Expr *left, Expr *right )
 //////////////////////////////////////////////////////////////////////
 // Integer division
 
-/** Implementation of the eval function for integer division. */
-static Value evalDiv( Expr *expr, Environment *env )
+/** Documented in the header. */
+Value applyDiv( Value v1, Value v2 )
 {
-  // If this function gets called, expr must really be a SimpleExpr.
-  SimpleExpr *this = (SimpleExpr *)expr;
-
-  // Evaluate our left and right operands. 
-  Value v1 = this->expr1->eval( this->expr1, env );
-  Value v2 = this->expr2->eval( this->expr2, env );
-
   // Make sure the operands are both integers.
   requireIntType( &v1 );
   requireIntType( &v2 );
 
   // Catch it if we try to divide by zero.
   if ( v2.ival == 0 ) {
-    fprintf( stderr, "Divide by zero\n" );
-    exit( EXIT_FAILURE );
+    fprintf( programErrors(), "Divide by zero\n" );
+    programExit();
   }
 
   // Return the quotient of the two expression.
   return (Value){ IntType, .ival = v1.ival / v2.ival };
 }
 
+/** Implementation of the eval function for integer division. */
+static Value evalDiv( Expr *expr, Environment *env )
+{
+  // If this function gets called, expr must really be a SimpleExpr.
+  SimpleExpr *this = (SimpleExpr *)expr;
+
+  // Evaluate our left and right operands. 
+  Value v1 = this->expr1->eval( this->expr1, env );
+  Value v2 = this->expr2->eval( this->expr2, env );
+
+  return applyDiv( v1, v2 );
+}
+
 /** Implementation of makeDiv which creates a new SimpleExpr for dividing expressions */
 Expr *makeDiv( Expr *left, Expr *right )
 {
@@ -353,16 +430,9 @@ Expr *makeOr( Expr *left, Expr *right )
 //////////////////////////////////////////////////////////////////////
 // Less-than comparison
 
-/** Implementation of eval for the less than operator. */
-static Value evalLess( Expr *expr, Environment *env )
+/** Compare two values with less-than, without freeing temporary operands */
+static Value lessValues( Value v1, Value v2 )
 {
-  // If this function gets called, expr must really be a SimpleExpr.
-  SimpleExpr *this = (SimpleExpr *)expr;
-
-  // Evaluate our left and right operands. 
-  Value v1 = this->expr1->eval( this->expr1, env );
-  Value v2 = this->expr2->eval( this->expr2, env );
-
   // Make sure the operands are both the same type.
   if ( v1.vtype != v2.vtype )
     reportTypeMismatch();
@@ -381,11 +451,11 @@ static Value evalLess( Expr *expr, Environment *env )
       int idx = 0;
 
       while(!v1IsLess && !v2IsLess && idx < v1.sval->len){
-        if(v1.sval->data[idx] < v2.sval->data[idx]){
+        if(seqGet(v1.sval, idx) < seqGet(v2.sval, idx)){
           v1IsLess = true;
         }
 
-        else if(v1.sval->data[idx] > v2.sval->data[idx]){
+        else if(seqGet(v1.sval, idx) > seqGet(v2.sval, idx)){
           v2IsLess = true;
         }
 
@@ -415,11 +485,11 @@ static Value evalLess( Expr *expr, Environment *env )
       int idx = 0;
 
       while(!v1IsLess && !v2IsLess && idx < v1.sval->len){
-        if(v1.sval->data[idx] < v2.sval->data[idx]){
+        if(seqGet(v1.sval, idx) < seqGet(v2.sval, idx)){
           v1IsLess = true;
         }
 
-        else if(v1.sval->data[idx] > v2.sval->data[idx]){
+        else if(seqGet(v1.sval, idx) > seqGet(v2.sval, idx)){
           v2IsLess = true;
         }
 
@@ -450,11 +520,11 @@ static Value evalLess( Expr *expr, Environment *env )
       int idx = 0;
 
       while(!v1IsLess && !v2IsLess && idx < v2.sval->len){
-        if(v1.sval->data[idx] < v2.sval->data[idx]){
+        if(seqGet(v1.sval, idx) < seqGet(v2.sval, idx)){
           v1IsLess = true;
         }
 
-        else if(v1.sval->data[idx] > v2.sval->data[idx]){
+        else if(seqGet(v1.sval, idx) > seqGet(v2.sval, idx)){
           v2IsLess = true;
         }
 
@@ -481,6 +551,28 @@ static Value evalLess( Expr *expr, Environment *env )
   }
 }
 
+/** Documented in the header. */
+Value applyLess( Value v1, Value v2 )
+{
+  Value result = lessValues( v1, v2 );
+  releaseTemporary( v1 );
+  releaseTemporary( v2 );
+  return result;
+}
+
+/** Implementation of eval for the less than operator. */
+static Value evalLess( Expr *expr, Environment *env )
+{
+  // If this function gets called, expr must really be a SimpleExpr.
+  SimpleExpr *this = (SimpleExpr *)expr;
+
+  // Evaluate our left and right operands. 
+  Value v1 = this->expr1->eval( this->expr1, env );
+  Value v2 = this->expr2->eval( this->expr2, env );
+
+  return applyLess( v1, v2 );
+}
+
 /** Implementation of makeLess which constructs a new SimpleExpr for verifying expressions our less than eachother or not */
 Expr *makeLess( Expr *left, Expr *right )
 {
@@ -492,16 +584,13 @@ Expr *makeLess( Expr *left, Expr *right )
 //////////////////////////////////////////////////////////////////////
 // Equality comparison
 
-/** Eval function for an equality test. */
-static Value evalEquals( Expr *expr, Environment *env )
-{
-  // If this function gets called, expr must really be a SimpleExpr.
-  SimpleExpr *this = (SimpleExpr *)expr;
-
-  // Evaluate our left and right operands. 
-  Value v1 = this->expr1->eval( this->expr1, env );
-  Value v2 = this->expr2->eval( this->expr2, env );
+/** Shortest sequence that's worth hashing to compare it.  Shorter ones
+    are quicker to just compare. */
+#define HASH_MIN_LEN 32
 
+/** Compare two values for equality, without freeing temporary operands */
+static Value equalValues( Value v1, Value v2 )
+{
   // Make sure the same type.
   if ( v1.vtype == IntType && v2.vtype == IntType ) {
     return (Value){ IntType, .ival = ( v1.ival == v2.ival ) };
@@ -510,12 +599,31 @@ static Value evalEquals( Expr *expr, Environment *env )
     // A sequence can also be compared to an int, but they should
     // never be considered equal.
     if(v1.vtype == SeqType && v2.vtype == SeqType){
+      // The same sequence, maybe through two variables.
+      if(v1.sval == v2.sval){
+        return (Value){ IntType, .ival = 1 };
+      }
+
       if(v1.sval->len == v2.sval->len){
+        // Sequences held by variables are likely to be compared again, so
+        // it's worth hashing them.  Once they're hashed, sequences that
+        // differ can usually be told apart without looking at them.
+        if(v1.sval->len >= HASH_MIN_LEN && v1.sval->ref > 0 && v2.sval->ref > 0 &&
+           seqHash(v1.sval) != seqHash(v2.sval)){
+          return (Value){ IntType, .ival = 0 };
+        }
+
+        // Sequences stored the same way can be compared as blocks of memory.
+        if(v1.sval->width == v2.sval->width){
+          bool same = memcmp(v1.sval->bytes, v2.sval->bytes, v1.sval->len * v1.sval->width) == 0;
+          return (Value){ IntType, .ival = same };
+        }
+
         bool notSame = false;
         int idx = 0;
 
         while(!notSame && idx < v1.sval->len){
-          if(v1.sval->data[idx] != v2.sval->data[idx]){
+          if(seqGet(v1.sval, idx) != seqGet(v2.sval, idx)){
             notSame = true;
           }
 
@@ -546,6 +654,28 @@ static Value evalEquals( Expr *expr, Environment *env )
   }
 }
 
+/** Documented in the header. */
+Value applyEquals( Value v1, Value v2 )
+{
+  Value result = equalValues( v1, v2 );
+  releaseTemporary( v1 );
+  releaseTemporary( v2 );
+  return result;
+}
+
+/** Eval function for an equality test. */
+static Value evalEquals( Expr *expr, Environment *env )
+{
+  // If this function gets called, expr must really be a SimpleExpr.
+  SimpleExpr *this = (SimpleExpr *)expr;
+
+  // Evaluate our left and right operands. 
+  Value v1 = this->expr1->eval( this->expr1, env );
+  Value v2 = this->expr2->eval( this->expr2, env );
+
+  return applyEquals( v1, v2 );
+}
+
 /** Implementation of makeEquals which constructs a new SimpleExpr for using equal to operator */
 Expr *makeEquals( Expr *left, Expr *right )
 {
@@ -606,6 +736,8 @@ Expr *makeVariable( char const *name )
 typedef struct {
   void (*execute)( Stmt *stmt, Environment *env );
   void (*destroy)( Stmt *stmt );
+  int line;
+  unsigned int trace;
 
   /** First (or only) expression used by this statement. */
   Expr *expr1;
@@ -627,6 +759,17 @@ static void destroySimpleStmt( Stmt *stmt )
   free( this );
 }
 
+/**
+ * Count a statement that's starting to run, and record it in the trace
+ * @param stmt the statement
+*/
+static inline __attribute__(( always_inline ))
+void startStatement( Stmt *stmt )
+{
+  countStatement();
+  traceStatement( stmt );
+}
+
 //////////////////////////////////////////////////////////////////////
 // Print Statement
 
@@ -635,19 +778,26 @@ static void executePrint( Stmt *stmt, Environment *env )
 {
   // If this function gets called, stmt must really be a SimpleStmt.
   SimpleStmt *this = (SimpleStmt *)stmt;
+  startStatement( stmt );
 
   // Evaluate our argument.
   Value v = this->expr1->eval( this->expr1, env );
 
   // Print the value of our expression appropriately, based on its type.
   if ( v.vtype == IntType ) {
-    printf( "%d", v.ival );
+    fprintf( programOutput(), "%d", v.ival );
   } else {
     grabSequence(v.sval);
-    // Replace with code to permit print a sequence as a string of
-    // ASCII character codes.
-    for(int i = 0; i < v.sval->len; i++){
-      putchar(v.sval->data[i]);
+    // Print a sequence as a string of ASCII character codes, all at once
+    // if it's stored as bytes.
+    if(v.sval->width == 1){
+      fwrite(v.sval->bytes, 1, v.sval->len, programOutput());
+    }
+
+    else {
+      for(int i = 0; i < v.sval->len; i++){
+        putc(v.sval->data[i], programOutput());
+      }
     }
 
     releaseSequence(v.sval);
@@ -662,6 +812,8 @@ Stmt *makePrint( Expr *expr )
 
   // Remember the pointers to execute and destroy this statement.
   this->execute = executePrint;
+  this->line = 0;
+  this->trace = 0;
   this->destroy = destroySimpleStmt;
 
   // Remember the expression for the thing we're supposed to print.
@@ -679,6 +831,8 @@ Stmt *makePrint( Expr *expr )
 typedef struct {
   void (*execute)( Stmt *stmt, Environment *env );
   void (*destroy)( Stmt *stmt );
+  int line;
+  unsigned int trace;
 
   /** Number of statements in the compound. */
   int len;
@@ -721,6 +875,8 @@ Stmt *makeCompound( int len, Stmt **stmtList )
 
   // Remember the pointers to execute and destroy this statement.
   this->execute = executeCompound;
+  this->line = 0;
+  this->trace = 0;
   this->destroy = destroyCompound;
 
   // Remember the list of statements in the compound.
@@ -738,6 +894,8 @@ Stmt *makeCompound( int len, Stmt **stmtList )
 typedef struct {
   void (*execute)( Stmt *stmt, Environment *env );
   void (*destroy)( Stmt *stmt );
+  int line;
+  unsigned int trace;
 
   // Condition to be checked before running the body.
   Expr *cond;
@@ -768,6 +926,7 @@ static void executeIf( Stmt *stmt, Environment *env )
 {
   // If this function gets called, stmt must really be a ConditionalStmt.
   ConditionalStmt *this = (ConditionalStmt *)stmt;
+  startStatement( stmt );
 
   // Evaluate our operand and see if it's true.
   Value result = this->cond->eval( this->cond, env );
@@ -787,6 +946,8 @@ Stmt *makeIf( Expr *cond, Stmt *body )
 
   // Functions to execute and destroy an if statement.
   this->execute = executeIf;
+  this->line = 0;
+  this->trace = 0;
   this->destroy = destroyConditional;
 
   // Fill in the condition and the body of the if.
@@ -805,6 +966,7 @@ static void executeWhile( Stmt *stmt, Environment *env )
 {
   // If this function gets called, stmt must really be a ConditionalStmt.
   ConditionalStmt *this = (ConditionalStmt *)stmt;
+  startStatement( stmt );
 
   // Evaluate our condition and see if it's true.
   Value result = this->cond->eval( this->cond, env );
@@ -813,6 +975,11 @@ static void executeWhile( Stmt *stmt, Environment *env )
   // Execute the body while the condition evaluates to true.
   while ( result.ival ) {
     this->body->execute( this->body, env );
+
+    // Each test of the condition counts as a statement, and the back edge
+    // is where a long-running program gets stopped or paused.
+    startStatement( stmt );
+    checkBudget();
     
     // Get the value of the condition for the next iteration.
     result = this->cond->eval( this->cond, env );
@@ -829,6 +996,8 @@ Stmt *makeWhile( Expr *cond, Stmt *body )
 
   // Functions to execute and destroy a while statement.
   this->execute = executeWhile;
+  this->line = 0;
+  this->trace = 0;
   this->destroy = destroyConditional;
 
   // Fill in the condition and the body of the while.
@@ -848,6 +1017,8 @@ Stmt *makeWhile( Expr *cond, Stmt *body )
 typedef struct {
   void (*execute)( Stmt *stmt, Environment *env );
   void (*destroy)( Stmt *stmt );
+  int line;
+  unsigned int trace;
 
   /** Name of the variable we're assigning to. */
   char name[ MAX_VAR_NAME + 1 ];
@@ -877,6 +1048,7 @@ static void executeAssignment( Stmt *stmt, Environment *env )
 {
   // If we get to this function, stmt must be an AssignmentStmt.
   AssignmentStmt *this = (AssignmentStmt *) stmt;
+  startStatement( stmt );
 
   // Evaluate the right-hand side of the equals.
   Value result = this->expr->eval( this->expr, env );
@@ -885,7 +1057,18 @@ static void executeAssignment( Stmt *stmt, Environment *env )
     Value idx = this->iexpr->eval( this->iexpr, env );
     // Replace with code to permit assigning to a sequence element.
     Value ret = lookupVariable( env, this->name);
-    ret.sval->data[idx.ival] = result.ival;
+
+    // Only an int can be stored in an existing element of a sequence.
+    requireSequence(&ret);
+    requireIntType(&idx);
+    requireIntType(&result);
+    if(idx.ival < 0 || idx.ival >= ret.sval->len){
+      fprintf(programErrors(), "Index out of bounds\n");
+      programExit();
+    }
+
+    seqSet(ret.sval, idx.ival, result.ival);
+    invalidateHash(ret.sval);
   } else {
     if(result.vtype == SeqType){
       grabSequence(result.sval);
@@ -905,6 +1088,8 @@ Stmt *makeAssignment( char const *name, Expr *iexpr, Expr *expr )
 
   // Fill in functions to execute or destory this statement.
   this->execute = executeAssignment;
+  this->line = 0;
+  this->trace = 0;
   this->destroy = destroyAssignment;
 
   // Get a copy of the destination variable name, the source
@@ -922,6 +1107,7 @@ static void executePush( Stmt *stmt, Environment *env )
 {
   // If we get to this function, stmt must be an AssignmentStmt.
   SimpleStmt *this = (SimpleStmt *) stmt;
+  startStatement( stmt );
 
   Value sequence = this->expr1->eval(this->expr1, env );
 
@@ -931,12 +1117,11 @@ static void executePush( Stmt *stmt, Environment *env )
 
   requireIntType(&val);
 
-  if(sequence.sval->len >= sequence.sval->cap){
-    sequence.sval->cap *= 2;
-    sequence.sval->data = realloc(sequence.sval->data, sequence.sval->cap * sizeof( int ));  
-  }
+  seqPush(sequence.sval, val.ival);
+  invalidateHash(sequence.sval);
 
-  sequence.sval->data[sequence.sval->len++] = val.ival;
+  // Pushing onto a temporary sequence has no lasting effect.
+  releaseTemporary(sequence);
 }
 
 /** Implementation of makePush for making push statements */
@@ -946,6 +1131,8 @@ Stmt *makePush( Expr *sexpr, Expr *vexpr )
   SimpleStmt * this = ( SimpleStmt * )malloc( sizeof( SimpleStmt ) );
 
   this->execute = executePush;
+  this->line = 0;
+  this->trace = 0;
 
   this->destroy = destroySimpleStmt;
 
@@ -985,16 +1172,11 @@ static Value evalSeqInti( Expr *expr, Environment *env ){
   Sequence * ret = makeSequence();
 
   for(int i = 0; i < this->len; i++){
-    if(ret->len >= ret->cap){
-      ret->cap *= 2;
-      ret->data = realloc(ret->data, ret->cap * sizeof( int ));
-    }
-
     Value v = this->exprList[i]->eval(this->exprList[i], env);
 
     requireIntType(&v);
 
-    ret->data[ret->len++] = (&v)->ival;
+    seqPush(ret, v.ival);
   }
 
   return (Value){SeqType, .sval = ret};
@@ -1032,29 +1214,207 @@ Expr *makeSequenceInitializer( int len, Expr * eList[] ) {
   return (Expr *)this;
 }
 
+/** Get an element of a sequence, without freeing a temporary sequence */
+static Value indexValue( Value seq, Value idx )
+{
+  requireSequence(&seq);
+
+  requireIntType(&idx);
+
+  if(idx.ival < 0 || idx.ival >= seq.sval->len){
+    // invalid index
+    // print to the program's error stream
+    fprintf(programErrors(), "Index out of bounds\n");
+    programExit();
+  }
+
+  return (Value){IntType, seqGet(seq.sval, idx.ival)};
+}
+
+/** Documented in the header. */
+Value applyIndex( Value seq, Value idx )
+{
+  Value result = indexValue( seq, idx );
+  releaseTemporary( seq );
+  return result;
+}
+
 /** Implementation of eval method for SequenceIndexExpression */
 static Value evalSeqIdx( Expr *expr, Environment *env ){
   SimpleExpr *this = (SimpleExpr *)expr;
 
   Value seq = this->expr1->eval(this->expr1, env);
 
+  // check the sequence before evaluating the index, so errors are reported in order
   requireSequence(&seq);
 
   Value idx = this->expr2->eval(this->expr2, env);
 
-  requireIntType(&idx);
-
-  if(idx.ival >= seq.sval->len){
-    // invalid index
-    // print to stderr
-    fprintf(stderr, "Index out of bounds\n");
-    exit( EXIT_FAILURE );
-  }
-
-  return (Value){IntType, seq.sval->data[idx.ival]};
+  return applyIndex( seq, idx );
 }
 
 /** Implementation of makeSequenceIndex which makes a new SequenceIndexExpression */
 Expr *makeSequenceIndex( Expr * aexpr, Expr * iexpr ){
   return buildSimpleExpr( aexpr, iexpr, evalSeqIdx);
-}
\ No newline at end of file
+}
+
+//////////////////////////////////////////////////////////////////////
+// Looking inside expressions and statements
+
+/** Documented in the header. */
+ExprKind exprKind( Expr *expr )
+{
+  // Each kind of expression is recognized by its eval function.
+  if ( expr->eval == evalLiteralInt )
+    return LiteralKind;
+  if ( expr->eval == evalVariable )
+    return VariableKind;
+  if ( expr->eval == evalAdd )
+    return AddKind;
+  if ( expr->eval == evalSub )
+    return SubKind;
+  if ( expr->eval == evalMul )
+    return MulKind;
+  if ( expr->eval == evalDiv )
+    return DivKind;
+  if ( expr->eval == evalAnd )
+    return AndKind;
+  if ( expr->eval == evalOr )
+    return OrKind;
+  if ( expr->eval == evalLess )
+    return LessKind;
+  if ( expr->eval == evalEquals )
+    return EqualsKind;
+  if ( expr->eval == evalLen )
+    return LenKind;
+  if ( expr->eval == evalSeqIdx )
+    return IndexKind;
+  if ( expr->eval == evalSeqInti )
+    return SeqInitKind;
+  if ( expr->eval == evalSort )
+    return SortKind;
+  if ( expr->eval == evalFind )
+    return FindKind;
+  return OtherExprKind;
+}
+
+/** Documented in the header. */
+int exprCount( Expr *expr )
+{
+  switch ( exprKind( expr ) ) {
+  case LiteralKind:
+  case VariableKind:
+  case OtherExprKind:
+    return 0;
+  case LenKind:
+  case SortKind:
+    return 1;
+  case SeqInitKind:
+    return ((SequenceInitializer *)expr)->len;
+  default:
+    return 2;
+  }
+}
+
+/** Documented in the header. */
+Expr **exprChild( Expr *expr, int i )
+{
+  if ( exprKind( expr ) == SeqInitKind )
+    return ((SequenceInitializer *)expr)->exprList + i;
+
+  // Everything else with sub-expressions is a SimpleExpr.
+  SimpleExpr *this = (SimpleExpr *)expr;
+  return i == 0 ? &this->expr1 : &this->expr2;
+}
+
+/** Documented in the header. */
+int literalValue( Expr *expr )
+{
+  return ((LiteralInt *)expr)->val;
+}
+
+/** Documented in the header. */
+char const *variableName( Expr *expr )
+{
+  return ((VariableExpr *)expr)->name;
+}
+
+/** Documented in the header. */
+StmtKind stmtKind( Stmt *stmt )
+{
+  // Each kind of statement is recognized by its execute function.
+  if ( stmt->execute == executePrint )
+    return PrintKind;
+  if ( stmt->execute == executePush )
+    return PushKind;
+  if ( stmt->execute == executeCompound )
+    return CompoundKind;
+  if ( stmt->execute == executeIf )
+    return IfKind;
+  if ( stmt->execute == executeWhile )
+    return WhileKind;
+  if ( stmt->execute == executeAssignment )
+    return AssignmentKind;
+  return OtherStmtKind;
+}
+
+/** Documented in the header. */
+int stmtExprCount( Stmt *stmt )
+{
+  switch ( stmtKind( stmt ) ) {
+  case PrintKind:
+  case IfKind:
+  case WhileKind:
+    return 1;
+  case PushKind:
+    return 2;
+  case AssignmentKind:
+    return ((AssignmentStmt *)stmt)->iexpr ? 2 : 1;
+  default:
+    return 0;
+  }
+}
+
+/** Documented in the header. */
+Expr **stmtExpr( Stmt *stmt, int i )
+{
+  switch ( stmtKind( stmt ) ) {
+  case IfKind:
+  case WhileKind:
+    return &((ConditionalStmt *)stmt)->cond;
+  case AssignmentKind:
+    return i == 0 ? &((AssignmentStmt *)stmt)->expr :
+      &((AssignmentStmt *)stmt)->iexpr;
+  default:
+    return i == 0 ? &((SimpleStmt *)stmt)->expr1 :
+      &((SimpleStmt *)stmt)->expr2;
+  }
+}
+
+/** Documented in the header. */
+int stmtBodyCount( Stmt *stmt )
+{
+  switch ( stmtKind( stmt ) ) {
+  case CompoundKind:
+    return ((CompoundStmt *)stmt)->len;
+  case IfKind:
+  case WhileKind:
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+/** Documented in the header. */
+Stmt **stmtBody( Stmt *stmt, int i )
+{
+  if ( stmtKind( stmt ) == CompoundKind )
+    return ((CompoundStmt *)stmt)->stmtList + i;
+  return &((ConditionalStmt *)stmt)->body;
+}
+
+/** Documented in the header. */
+char const *assignmentName( Stmt *stmt )
+{
+  return ((AssignmentStmt *)stmt)->name;
+}
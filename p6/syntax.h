@@ -63,6 +63,22 @@ Expr *makeSequenceInitializer( int len, Expr * eList[] );
 */
 Expr *makeLenExpr( Expr *expr );
 
+/**
+ * Constructs a new SimpleExpr for the sort builtin, which evaluates to a sorted copy of a sequence
+ * @param expr expression for the sequence to sort
+ * @return a new sort expression
+*/
+Expr *makeSortExpr( Expr *expr );
+
+/**
+ * Constructs a new SimpleExpr for the find builtin, which evaluates to the index where one
+ * sequence first occurs in another, or -1 if it doesn't
+ * @param seq expression for the sequence to search
+ * @param sub expression for the sequence to look for
+ * @return a new find expression
+*/
+Expr *makeFindExpr( Expr *seq, Expr *sub );
+
 /**
  * Constructs a new SequenceIndexExpr so we can add elements to a sequence at a passed index
  * @param aexpr an expression for the element we want to add to our sequence
@@ -150,6 +166,66 @@ Expr *makeOr( Expr *left, Expr *right );
  */
 Expr *makeVariable( char const *name );
 
+/** Exit with a type mismatch error if the given value isn't an int.
+    @param v value to check, passed by address.
+ */
+void requireIntType( Value const *v );
+
+/** Exit with a type mismatch error if the given value isn't a sequence.
+    @param v value to check, passed by address.
+ */
+void requireSequence( Value const *v );
+
+/** Divide one int value by another, as the division operator does, exiting
+    with an error for a type mismatch or division by zero.
+    @param v1 value to divide.
+    @param v2 value to divide by.
+    @return the quotient.
+ */
+Value applyDiv( Value v1, Value v2 );
+
+/** Compare two values with the less-than operator.  Ints compare
+    numerically and sequences compare lexicographically.
+    @param v1 left-hand operand.
+    @param v2 right-hand operand.
+    @return an int value, 1 if v1 is less than v2 or 0 otherwise.
+ */
+Value applyLess( Value v1, Value v2 );
+
+/** Compare two values with the equality operator.
+    @param v1 left-hand operand.
+    @param v2 right-hand operand.
+    @return an int value, 1 if the values are equal or 0 otherwise.
+ */
+Value applyEquals( Value v1, Value v2 );
+
+/** Compute the len of a value, which must be a sequence.
+    @param v value to measure.
+    @return an int value containing the sequence length.
+ */
+Value applyLen( Value v );
+
+/** Make a sorted copy of a value, which must be a sequence.
+    @param v value to sort.
+    @return a sequence value holding the sorted elements.
+ */
+Value applySort( Value v );
+
+/** Find where one sequence first occurs in another.
+    @param seq value that should be the sequence to search.
+    @param sub value that should be the sequence to look for.
+    @return an int value, the index of the first occurrence or -1.
+ */
+Value applyFind( Value seq, Value sub );
+
+/** Get an element of a sequence, exiting with an error if the index is
+    out of bounds.
+    @param seq value that should be a sequence.
+    @param idx value that should be an int index into the sequence.
+    @return an int value for the selected element.
+ */
+Value applyIndex( Value seq, Value idx );
+
 //////////////////////////////////////////////////////////////////////
 // Stmt, an interface for a statement in the input program.
 
@@ -157,7 +233,7 @@ Expr *makeVariable( char const *name );
 typedef struct StmtStruct Stmt;
 
 /** Representation for the Stmt interface, a superclass for all types
-    of statements.  Classes implementing this have these two fields as
+    of statements.  Classes implementing this have these three fields as
     their first members.  They will set execute to point to an
     appropriate functions to execute the type of statement their
     class represents, and they will set destroy to point to a function
@@ -175,6 +251,15 @@ struct StmtStruct {
       @param stmt statement to free.
   */
   void (*destroy)( Stmt *stmt );
+
+  /** Line the statement starts on, for tracing.  Filled in by the
+      parser. */
+  int line;
+
+  /** The line and kind of statement, packed the way trace entries hold
+      them, so tracing doesn't have to work them out every time the
+      statement runs.  Filled in by the parser. */
+  unsigned int trace;
 };
 
 /** Make a statement that evaluates the given argument and prints it
@@ -234,4 +319,92 @@ Stmt *makeAssignment( char const *name, Expr *iexpr, Expr *expr );
 */
 Stmt *makePush( Expr *sexpr, Expr *vexpr );
 
+//////////////////////////////////////////////////////////////////////
+// Looking inside expressions and statements, for code that analyzes or
+// transforms a parsed program.
+
+/** Kinds of expressions, as reported by exprKind(). */
+typedef enum { LiteralKind, VariableKind, AddKind, SubKind, MulKind, DivKind,
+               AndKind, OrKind, LessKind, EqualsKind, LenKind, IndexKind,
+               SeqInitKind, SortKind, FindKind, OtherExprKind } ExprKind;
+
+/** Report what kind of expression this is.
+    @param expr expression to check.
+    @return kind of the expression.
+ */
+ExprKind exprKind( Expr *expr );
+
+/** Report how many sub-expressions an expression has.
+    @param expr expression to check.
+    @return number of sub-expressions.
+ */
+int exprCount( Expr *expr );
+
+/** Get the address of one of the sub-expression pointers in an
+    expression, so it can be examined or replaced.  Operands of a binary
+    expression are numbered left to right, starting from zero.
+    @param expr expression containing the sub-expression.
+    @param i index of the sub-expression.
+    @return address of the pointer to the sub-expression.
+ */
+Expr **exprChild( Expr *expr, int i );
+
+/** Return the value of a LiteralKind expression.
+    @param expr the literal expression.
+    @return value the literal evaluates to.
+ */
+int literalValue( Expr *expr );
+
+/** Return the name of the variable in a VariableKind expression.
+    @param expr the variable expression.
+    @return name of the variable.
+ */
+char const *variableName( Expr *expr );
+
+/** Kinds of statements, as reported by stmtKind(). */
+typedef enum { PrintKind, PushKind, CompoundKind, IfKind, WhileKind,
+               AssignmentKind, OtherStmtKind } StmtKind;
+
+/** Report what kind of statement this is.
+    @param stmt statement to check.
+    @return kind of the statement.
+ */
+StmtKind stmtKind( Stmt *stmt );
+
+/** Report how many expressions a statement uses directly.
+    @param stmt statement to check.
+    @return number of expressions.
+ */
+int stmtExprCount( Stmt *stmt );
+
+/** Get the address of one of the expression pointers in a statement.
+    The condition of an if or while is expression 0; for push, the
+    sequence is 0 and the value is 1; for an assignment, the right-hand
+    side is 0 and the index, if there is one, is 1.
+    @param stmt statement containing the expression.
+    @param i index of the expression.
+    @return address of the pointer to the expression.
+ */
+Expr **stmtExpr( Stmt *stmt, int i );
+
+/** Report how many statements are nested directly inside a statement,
+    the body of an if or while or the list in a compound.
+    @param stmt statement to check.
+    @return number of nested statements.
+ */
+int stmtBodyCount( Stmt *stmt );
+
+/** Get the address of one of the statement pointers nested in a statement.
+    @param stmt statement containing the nested statements.
+    @param i index of the nested statement.
+    @return address of the pointer to the nested statement.
+ */
+Stmt **stmtBody( Stmt *stmt, int i );
+
+/** Return the name of the variable an AssignmentKind statement assigns to.
+    @param stmt the assignment statement.
+    @return name of the variable.
+ */
+char const *assignmentName( Stmt *stmt );
+
 #endif
@@ -99,8 +99,8 @@ testInterpreter() {
   echo "Test $TESTNO"
   rm -f output.txt stderr.txt
 
-  echo "   ./interpret prog-$TESTNO.txt > output.txt 2> stderr.txt"
-  ./interpret prog-$TESTNO.txt > output.txt 2> stderr.txt
+  echo "   $INTERP prog-$TESTNO.txt > output.txt 2> stderr.txt"
+  $INTERP prog-$TESTNO.txt > output.txt 2> stderr.txt
   ASTATUS=$?
 
   if ! checkStatus "$ESTATUS" "$ASTATUS" ||
@@ -115,12 +115,89 @@ testInterpreter() {
   return 0
 }
 
-# Get a clean build of the project.
-make clean
-make
+# Test a run of the interpreter in batch mode, with the given arguments
+# after the list of programs.
+testBatch() {
+  TESTNO=$1
+  ESTATUS=$2
+  shift 2
 
-# Run against the test inputs.
-if [ -x interpret ]; then
+  echo "Test $TESTNO"
+  rm -f output.txt stderr.txt
+
+  echo "   ./interpret --batch batch-list.txt $@ > output.txt 2> stderr.txt"
+  ./interpret --batch batch-list.txt "$@" > output.txt 2> stderr.txt
+  ASTATUS=$?
+
+  if ! checkStatus "$ESTATUS" "$ASTATUS" ||
+     ! checkFile "Stdout output" "expected-batch.txt" "output.txt" ||
+     ! checkFileOrEmpty "Stderr output" "message-batch.txt" "stderr.txt"
+  then
+      FAIL=1
+      return 1
+  fi
+
+  echo "Test $TESTNO PASS"
+  return 0
+}
+
+# Test the trace dumped when a program in a batch fails, with the given
+# arguments after the list of programs.  The list has a clean program
+# followed by a failing one, and the failing program's trace should only
+# show its own statements.  Times are left out of the trace.
+testTrace() {
+  TESTNO=$1
+  ESTATUS=$2
+  shift 2
+
+  echo "Test $TESTNO"
+  rm -f output.txt stderr.txt
+
+  echo "   ./interpret --trace --batch trace-list.txt $@ > output.txt 2> stderr.txt"
+  ./interpret --trace --batch trace-list.txt "$@" > output.txt 2> stderr.txt
+  ASTATUS=$?
+  sed 's/  [0-9]*$//' stderr.txt > messages.txt
+
+  if ! checkStatus "$ESTATUS" "$ASTATUS" ||
+     ! checkFile "Stdout output" "expected-trace.txt" "output.txt" ||
+     ! checkFileOrEmpty "Stderr output" "message-trace.txt" "messages.txt"
+  then
+      FAIL=1
+      return 1
+  fi
+
+  echo "Test $TESTNO PASS"
+  return 0
+}
+
+# Test the interpreter in $INTERP in REPL mode, typing in the program
+# with the given number.  Timing lines are left out of its error output.
+testRepl() {
+  TESTNO=$1
+  ESTATUS=$2
+
+  echo "Test $TESTNO"
+  rm -f output.txt stderr.txt
+
+  echo "   $INTERP --repl < prog-$TESTNO.txt > output.txt 2> stderr.txt"
+  $INTERP --repl < prog-$TESTNO.txt > output.txt 2> stderr.txt
+  ASTATUS=$?
+  grep -v '^time: ' stderr.txt > messages.txt
+
+  if ! checkStatus "$ESTATUS" "$ASTATUS" ||
+     ! checkFile "Stdout output" "expected-$TESTNO.txt" "output.txt" ||
+     ! checkFileOrEmpty "Stderr output" "message-$TESTNO.txt" "messages.txt"
+  then
+      FAIL=1
+      return 1
+  fi
+
+  echo "Test $TESTNO PASS"
+  return 0
+}
+
+# Run all the program tests against the interpreter in $INTERP.
+testPrograms() {
     testInterpreter 01 0
     testInterpreter 02 0
     testInterpreter 03 0
@@ -140,10 +217,69 @@ if [ -x interpret ]; then
     testInterpreter 17 1
     testInterpreter 18 1
     testInterpreter 19 1
+    testInterpreter 20 0
+    testInterpreter 21 1
+    testInterpreter 22 0
+    testInterpreter 23 1
+    testInterpreter 24 1
+    testInterpreter 26 0
+    testRepl 27 1
+}
+
+# Get a clean build of the project.
+make clean
+make
+
+# Run against the test inputs.
+if [ -x interpret ]; then
+    INTERP=./interpret
+    testPrograms
+    testBatch batch 1
+    testBatch batch-j3 1 -j 3
+    testBatch batch-slice 1 -j 2 --slice 10
+
+    # Programs run one after another, or taking turns, on the same thread.
+    testTrace trace 1 -j 1
+    testTrace trace-slice 1 -j 1 --slice 2
+
+    # A runaway program gets stopped by its statement budget.
+    INTERP="./interpret --budget 1000"
+    testInterpreter 25 1
 else
     fail "Since your program didn't compile, we couldn't test it"
 fi
 
+# The computed-goto engine should behave exactly the same.
+make interpret-flat
+
+if [ -x interpret-flat ]; then
+    INTERP=./interpret-flat
+    testPrograms
+else
+    fail "Couldn't build interpret-flat"
+fi
+
+# So should the JIT, along with the tiers below it.
+make interpret-jit
+
+if [ -x interpret-jit ]; then
+    INTERP=./interpret-jit
+    testPrograms
+
+    # Native loops don't count statements, so they must not run with a budget.
+    INTERP="./interpret-jit --budget 1000 --jit-threshold 1"
+    testInterpreter 25 1
+else
+    fail "Couldn't build interpret-jit"
+fi
+
+# All the engines should also agree on a batch of randomly generated programs.
+echo "Running differential test"
+if ! ./difftest.sh 100 > stdout.txt; then
+    cat stdout.txt
+    fail "Engines disagree on generated programs"
+fi
+
 if [ $FAIL -ne 0 ]; then
   echo "FAILING TESTS!"
   exit 13
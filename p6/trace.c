@@ -0,0 +1,234 @@
+/**
+ * @file trace.c
+ * @author Jake Donovan (jmpatte8)
+ * Per-thread execution trace buffers, the trace clock, and dumping the buffers on an error or on
+ * SIGUSR1.  Dumps are formatted by hand, and written with write() except when they go to a program's
+ * error stream, so they're safe to do from a signal handler
+*/
+
+#define _DEFAULT_SOURCE
+
+#include "trace.h"
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+/** Most threads that can be registered for SIGUSR1 dumps at once. */
+#define TRACE_THREADS 128
+
+/** Documented in the header. */
+__thread TraceRing traceRing;
+
+/** Documented in the header. */
+bool traceEnabled = false;
+
+/** Documented in the header. */
+volatile uint64_t traceNow = 0;
+
+/** Buffers of the registered threads, with NULL for unused slots. */
+static TraceRing *volatile threadRing[ TRACE_THREADS ];
+
+/** File descriptor for the trace file, or -1 if there isn't one. */
+static volatile int traceFile = -1;
+
+/** Name of each kind of statement, in the same order as StmtKind. */
+static char const *kindName[] = { "print", "push", "compound", "if", "while",
+                                  "assign", "other" };
+
+/** When tracing started. */
+static struct timespec traceStart;
+
+/**
+ * Handler for SIGALRM, which comes every tick.  It sets the trace clock from how long it's been since
+ * tracing started, so a late signal doesn't slow the clock down
+ * @param sig the signal number
+*/
+static void tick( int sig )
+{
+  struct timespec now;
+  clock_gettime( CLOCK_MONOTONIC, &now );
+  uint64_t ticks = ( ( now.tv_sec - traceStart.tv_sec ) * 1000 +
+                     ( now.tv_nsec - traceStart.tv_nsec ) / 1000000 ) / TRACE_TICK_MS;
+  traceNow = ticks << TRACE_TIME_SHIFT;
+}
+
+/** Documented in the header. */
+void traceThreadStart()
+{
+  for ( int i = 0; i < TRACE_THREADS; i++ )
+    if ( __sync_bool_compare_and_swap( threadRing + i, NULL, &traceRing ) )
+      return;
+
+  // No room, this thread just won't be dumped on SIGUSR1.
+}
+
+/** Documented in the header. */
+void traceThreadEnd()
+{
+  for ( int i = 0; i < TRACE_THREADS; i++ )
+    if ( __sync_bool_compare_and_swap( threadRing + i, &traceRing, NULL ) )
+      return;
+}
+
+/**
+ * Add a string to the end of a line being built
+ * @param buf the line
+ * @param len current length of the line, updated
+ * @param str the string to add
+*/
+static void addString( char *buf, int *len, char const *str )
+{
+  while ( *str )
+    buf[ ( *len )++ ] = *str++;
+}
+
+/**
+ * Add a number to the end of a line being built, right-justified in the given width
+ * @param buf the line
+ * @param len current length of the line, updated
+ * @param val the number to add
+ * @param width smallest number of characters to use
+*/
+static void addNumber( char *buf, int *len, uint64_t val, int width )
+{
+  char digits[ 24 ];
+  int n = 0;
+  do {
+    digits[ n++ ] = '0' + val % 10;
+    val /= 10;
+  } while ( val );
+
+  while ( width-- > n )
+    buf[ ( *len )++ ] = ' ';
+  while ( n )
+    buf[ ( *len )++ ] = digits[ --n ];
+}
+
+/**
+ * Write part of a trace dump to a file descriptor
+ * @param dest pointer to the file descriptor
+ * @param buf what to write
+ * @param len number of bytes to write
+*/
+static void writeFd( void *dest, char const *buf, int len )
+{
+  write( *(int *) dest, buf, len );
+}
+
+/**
+ * Write part of a trace dump to a stream
+ * @param dest the stream
+ * @param buf what to write
+ * @param len number of bytes to write
+*/
+static void writeStream( void *dest, char const *buf, int len )
+{
+  fwrite( buf, 1, len, (FILE *) dest );
+}
+
+/**
+ * Write a ring buffer out, oldest entry first.  Each entry shows its line, its kind, and how many
+ * milliseconds it came before the newest entry, to the nearest tick of the trace clock
+ * @param ring the buffer to dump
+ * @param out function that writes each part of the dump
+ * @param dest where out() should write
+*/
+static void dumpRing( TraceRing const *ring, void (*out)( void *, char const *, int ), void *dest )
+{
+  unsigned long count = ring->count;
+  unsigned long n = count < TRACE_SIZE ? count : TRACE_SIZE;
+  uint32_t newest = n ? ring->entry[ ( count - 1 ) & TRACE_MASK ] >> TRACE_TIME_SHIFT : 0;
+
+  char buf[ 128 ];
+  int len = 0;
+  addString( buf, &len, "trace: last " );
+  addNumber( buf, &len, n, 0 );
+  addString( buf, &len, " of " );
+  addNumber( buf, &len, count, 0 );
+  addString( buf, &len, " statements, oldest first, in ms before the newest\n" );
+  out( dest, buf, len );
+
+  for ( unsigned long i = count - n; i < count; i++ ) {
+    uint64_t e = ring->entry[ i & TRACE_MASK ];
+    uint32_t time = e >> TRACE_TIME_SHIFT;
+    int line = (uint32_t) e >> TRACE_KIND_BITS;
+    int kind = e & ( ( 1 << TRACE_KIND_BITS ) - 1 );
+    if ( kind > OtherStmtKind )
+      kind = OtherStmtKind;
+
+    len = 0;
+    addString( buf, &len, "  line " );
+    addNumber( buf, &len, line, 5 );
+    addString( buf, &len, "  " );
+    addString( buf, &len, kindName[ kind ] );
+    addString( buf, &len, "  " );
+    addNumber( buf, &len, (uint64_t)(uint32_t)( newest - time ) * TRACE_TICK_MS, 0 );
+    buf[ len++ ] = '\n';
+    out( dest, buf, len );
+  }
+}
+
+/** Documented in the header. */
+void traceDump( int fd )
+{
+  dumpRing( &traceRing, writeFd, &fd );
+}
+
+/**
+ * Handler for SIGUSR1, dumps the buffer of every registered thread
+ * @param sig the signal number
+*/
+static void dumpAll( int sig )
+{
+  int fd = traceFile >= 0 ? traceFile : STDERR_FILENO;
+  for ( int i = 0; i < TRACE_THREADS; i++ ) {
+    TraceRing *ring = threadRing[ i ];
+    if ( ring ) {
+      write( fd, "thread ", 7 );
+      char buf[ 8 ];
+      int len = 0;
+      addNumber( buf, &len, i, 0 );
+      buf[ len++ ] = ' ';
+      write( fd, buf, len );
+      dumpRing( ring, writeFd, &fd );
+    }
+  }
+}
+
+/** Documented in the header. */
+void startTrace( int fd )
+{
+  traceFile = fd;
+  traceEnabled = true;
+
+  struct sigaction act;
+  memset( &act, 0, sizeof( act ) );
+  act.sa_handler = dumpAll;
+  sigemptyset( &act.sa_mask );
+  act.sa_flags = SA_RESTART;
+  sigaction( SIGUSR1, &act, NULL );
+
+  // The clock runs off a timer signal, not a thread of its own, since
+  // just having another thread makes the C library take locks for every
+  // malloc() and every character of output.
+  clock_gettime( CLOCK_MONOTONIC, &traceStart );
+  act.sa_handler = tick;
+  sigaction( SIGALRM, &act, NULL );
+
+  struct itimerval timer = { { 0, TRACE_TICK_MS * 1000 }, { 0, TRACE_TICK_MS * 1000 } };
+  setitimer( ITIMER_REAL, &timer, NULL );
+}
+
+/** Documented in the header. */
+void traceError( FILE *err )
+{
+  if ( !traceEnabled )
+    return;
+
+  if ( traceFile >= 0 )
+    traceDump( traceFile );
+  else
+    dumpRing( &traceRing, writeStream, err );
+}
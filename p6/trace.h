@@ -0,0 +1,123 @@
+/**
+  @file trace.h
+  @author Jake Donovan (jmpatte8)
+
+  Execution trace.  With tracing turned on, every statement the
+  interpreter runs is recorded in a fixed-size ring buffer for its
+  thread, with its line number, what kind of statement it is and a
+  timestamp, so there's a record of what a program was doing right
+  before something went wrong.  A thread only ever writes to its own
+  buffer, so recording takes no locks.
+
+  Recording a statement is a single store.  The timestamp comes from a
+  coarse clock that a timer signal advances every TRACE_TICK_MS, so the
+  interpreter never reads the clock itself.
+
+  When a program hits an error, the buffer for its thread is dumped to
+  the trace file, or along with the program's error messages if there
+  isn't one.  On SIGUSR1, the buffers for every registered thread are
+  dumped, to the trace file or to standard error.
+*/
+
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "syntax.h"
+
+/** Number of entries in each thread's ring buffer, a power of two. */
+#define TRACE_SIZE 1024
+
+/** Mask that turns a statement count into an index in the ring. */
+#define TRACE_MASK ( TRACE_SIZE - 1 )
+
+/** Milliseconds between ticks of the trace clock. */
+#define TRACE_TICK_MS 10
+
+/** Bits at the bottom of a trace entry holding the statement kind. */
+#define TRACE_KIND_BITS 3
+
+/** Bits at the bottom of a trace entry holding the line and kind, with
+    the time above them. */
+#define TRACE_TIME_SHIFT 32
+
+/** Ring buffer of the most recent statements run on a thread. */
+typedef struct {
+  /** Entries, written in a circle.  Each one holds the trace clock in
+      the bits above TRACE_TIME_SHIFT, then the line the statement starts
+      on, shifted left by TRACE_KIND_BITS, and the kind of statement in
+      the bits below it. */
+  uint64_t entry[ TRACE_SIZE ];
+  /** Number of statements ever recorded, so the next entry goes in
+      entry[ count & TRACE_MASK ]. */
+  unsigned long count;
+} TraceRing;
+
+/** Ring buffer for the current thread. */
+extern __thread TraceRing traceRing;
+
+/** True once tracing has been turned on with startTrace(). */
+extern bool traceEnabled;
+
+/** Trace clock, in ticks of TRACE_TICK_MS since tracing started,
+    already shifted up by TRACE_TIME_SHIFT so it can just be or'd into an
+    entry. */
+extern volatile uint64_t traceNow;
+
+/** Pack a statement's line and kind the way a trace entry holds them.
+    @param line the line the statement starts on.
+    @param kind what kind of statement it is.
+    @return the packed line and kind, for the statement's trace field.
+*/
+static inline unsigned int traceTag( int line, StmtKind kind )
+{
+  return (unsigned int) line << TRACE_KIND_BITS | kind;
+}
+
+/** Record a statement as it starts running.  This is all the tracing
+    that happens on the interpreter's hot path: one test of a flag that
+    never changes, and one store to a masked index.
+    @param stmt the statement, with its trace field filled in.
+*/
+static inline __attribute__(( always_inline ))
+void traceStatement( Stmt *stmt )
+{
+#ifndef NO_TRACE
+  if ( traceEnabled )
+    traceRing.entry[ traceRing.count++ & TRACE_MASK ] = traceNow | stmt->trace;
+#endif
+}
+
+/** Register the current thread's buffer, so it gets dumped on SIGUSR1.
+    Threads should call traceThreadEnd() before they exit.
+*/
+void traceThreadStart();
+
+/** Unregister the current thread's buffer. */
+void traceThreadEnd();
+
+/** Write the current thread's buffer to a file descriptor, oldest entry
+    first.  This is safe to call from a signal handler.
+    @param fd where to write the trace.
+*/
+void traceDump( int fd );
+
+/** Turn tracing on, before any programs start running.  This starts
+    the trace clock, which uses SIGALRM, and dumps every registered
+    thread's buffer on SIGUSR1.
+    @param fd file descriptor for the trace file, or -1 for none.  With
+    no trace file, errors are dumped with the program's error messages,
+    and SIGUSR1 dumps to standard error.
+*/
+void startTrace( int fd );
+
+/** Dump the current thread's buffer, if tracing is on.  Called when a
+    program stops with an error.
+    @param err where the program's error messages go, used if there's
+    no trace file.
+*/
+void traceError( FILE *err );
+
+#endif
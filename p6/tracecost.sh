@@ -0,0 +1,63 @@
+#!/bin/bash
+# Measure what statement tracing costs, by timing the interpreter with
+# tracing turned on against a build with tracing compiled out, on the
+# same programs as bench.sh.  Set TRACE to the options that turn tracing
+# on, or to nothing to measure what it costs while it's turned off.
+# Runs of the two builds alternate, and each program's overhead is the
+# median over all the pairs of runs, to keep noise from other processes
+# out of the result.  The total is the median over runs of the overhead
+# on the whole set of programs.
+#
+# usage: ./tracecost.sh [runs] [corpus-repeat-count]
+
+RUNS=${1:-21}
+REPEAT=${2:-100}
+TRACE=${TRACE---trace-file /dev/null}
+
+make interpret interpret-notrace > /dev/null || exit 1
+
+# Build the batch list for the corpus, all the tests that run successfully.
+LIST=corpus-list.txt
+rm -f $LIST
+for (( i = 0; i < REPEAT; i++ )); do
+    for t in 01 02 03 04 05 06 07 08 09 10 11 12 13 14 15; do
+        echo prog-$t.txt >> $LIST
+    done
+done
+
+# Print the CPU time, in seconds, for running the given command.
+timeRun() {
+    TIMEFORMAT="%U %S"
+    { time "$@" > /dev/null 2>&1; } 2>&1 | awk '{ print $1 + $2 }'
+}
+
+# Each run times every program once with each build, alternating, so a
+# slow spell on the machine hits both builds about the same.
+for (( r = 0; r < RUNS; r++ )); do
+    for b in corpus bench-*.txt; do
+        if [ $b == corpus ]; then
+            ARGS="--batch $LIST"
+        else
+            ARGS=$b
+        fi
+
+        echo ${b%.txt} $r $( timeRun ./interpret $TRACE $ARGS ) $( timeRun ./interpret-notrace $ARGS )
+    done
+done > tracecost.out
+
+# The total for each run counts as one more program.
+awk '{ on[ $2 ] += $3; off[ $2 ] += $4; print }
+     END { for ( r in on ) print "total", r, on[ r ], off[ r ] }' tracecost.out > tracecost.all
+
+# Report the mean times, and the median overhead over all the runs.
+printf "%-10s %10s %10s %9s\n" program traced untraced overhead
+for b in corpus bench-*.txt total; do
+    awk -v n=${b%.txt} '$1 == n { print $3, $4, ( $3 - $4 ) * 100 / $4 }' tracecost.all |
+        sort -g -k 3 |
+        awk -v n=${b%.txt} -v mid=$(( ( RUNS + 1 ) / 2 )) '
+            { on += $1; off += $2 }
+            NR == mid { median = $3 }
+            END { printf "%-10s %10.3f %10.3f %8.1f%%\n", n, on / NR, off / NR, median }'
+done
+
+rm -f $LIST tracecost.out tracecost.all
@@ -6,10 +6,14 @@
 */
 
 #include "value.h"
+#include "pool.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <assert.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 //////////////////////////////////////////////////////////////////////
 // Sequence.
@@ -19,11 +23,45 @@
 */
 Sequence *makeSequence()
 {
-  Sequence *seq = (Sequence *)malloc(sizeof( Sequence ));
+  Sequence *seq = (Sequence *)poolAlloc(sizeof( Sequence ));
   seq->len = 0;
-  seq->cap = 5;
-  seq->data = (int *)malloc(seq->cap * sizeof( int ));
+  // use all the room in the smallest pool block
+  seq->cap = poolBlockSize(5);
+  // start out with one byte per element, widening later if we need to
+  seq->width = 1;
+  seq->bytes = (signed char *)poolAlloc(seq->cap * seq->width);
   seq->ref = 0;
+  seq->hash = 0;
+  return seq;
+}
+
+/**
+ * Convert a byte sequence to int storage, keeping all its elements
+ * @param seq the sequence to widen
+*/
+void widenSequence( Sequence *seq )
+{
+  int *data = (int *)poolAlloc(seq->cap * sizeof( int ));
+  for(int i = 0; i < seq->len; i++){
+    data[i] = seq->bytes[i];
+  }
+
+  poolFree(seq->bytes, seq->cap);
+  seq->data = data;
+  seq->width = sizeof( int );
+}
+
+/**
+ * Double the capacity of a sequence if it's full
+ * @param seq the sequence that needs room for another element
+*/
+void growSequence( Sequence *seq )
+{
+  if(seq->len >= seq->cap){
+    seq->bytes = (signed char *)poolRealloc(seq->bytes, seq->cap * seq->width,
+                                            2 * seq->cap * seq->width);
+    seq->cap *= 2;
+  }
 }
 
 /**
@@ -32,8 +70,8 @@ Sequence *makeSequence()
 */
 void freeSequence( Sequence *seq )
 {
-  free(seq->data);
-  free(seq);
+  poolFree(seq->bytes, seq->cap * seq->width);
+  poolFree(seq, sizeof( Sequence ));
 }
 
 /**
@@ -62,6 +100,225 @@ void releaseSequence( Sequence *seq )
   }
 }
 
+/**
+ * Mix one element into a hash
+ * @param h hash of the elements so far
+ * @param val the next element
+ * @return hash including val
+*/
+static inline unsigned mixHash( unsigned h, int val )
+{
+  return ( ( h << 5 | h >> 27 ) ^ (unsigned) val ) * 0x9E3779B1u;
+}
+
+/** Documented in the header. */
+unsigned seqHash( Sequence *seq )
+{
+  if ( seq->hash )
+    return seq->hash;
+
+  // Start from the length, so a run of zeros doesn't hash like an empty sequence.
+  unsigned h = seq->len;
+  if ( seq->width == 1 ) {
+    for ( int i = 0; i < seq->len; i++ )
+      h = mixHash( h, seq->bytes[ i ] );
+  } else {
+    for ( int i = 0; i < seq->len; i++ )
+      h = mixHash( h, seq->data[ i ] );
+  }
+
+  // Zero means not computed yet.
+  seq->hash = h ? h : 1;
+  return seq->hash;
+}
+
+/**
+ * Make sure a sequence has room for at least the given number of elements
+ * @param seq the sequence to make room in
+ * @param n number of elements it needs to hold
+*/
+static void reserveSequence( Sequence *seq, int n )
+{
+  int cap = seq->cap;
+  while ( cap < n )
+    cap *= 2;
+  if ( cap != seq->cap ) {
+    seq->bytes = (signed char *)poolRealloc(seq->bytes, seq->cap * seq->width,
+                                            cap * seq->width);
+    seq->cap = cap;
+  }
+}
+
+/**
+ * Sort ints with an LSD radix sort, one byte of the key per pass.  Keys have their sign bit
+ * flipped, so negative values come first.  A pass is skipped if every key has the same digit
+ * there, which is common for small values
+ * @param data the values to sort, sorted in place
+ * @param n number of values
+*/
+static void radixSort( int *data, int n )
+{
+  unsigned *src = (unsigned *)data;
+  unsigned *dst = (unsigned *)malloc( n * sizeof( unsigned ) );
+  unsigned *scratch = dst;
+
+  for ( int i = 0; i < n; i++ )
+    src[ i ] ^= 0x80000000u;
+
+  for ( int shift = 0; shift < 32; shift += 8 ) {
+    int count[ 256 ] = { 0 };
+    for ( int i = 0; i < n; i++ )
+      count[ ( src[ i ] >> shift ) & 0xFF ]++;
+    if ( count[ ( src[ 0 ] >> shift ) & 0xFF ] == n )
+      continue;
+
+    // Turn counts into starting positions, then distribute stably.
+    int pos = 0;
+    for ( int d = 0; d < 256; d++ ) {
+      int c = count[ d ];
+      count[ d ] = pos;
+      pos += c;
+    }
+    for ( int i = 0; i < n; i++ )
+      dst[ count[ ( src[ i ] >> shift ) & 0xFF ]++ ] = src[ i ];
+
+    unsigned *t = src;
+    src = dst;
+    dst = t;
+  }
+
+  // An odd number of passes leaves the result in the scratch array.
+  if ( src != (unsigned *)data )
+    memcpy( data, src, n * sizeof( unsigned ) );
+  for ( int i = 0; i < n; i++ )
+    ( (unsigned *)data )[ i ] ^= 0x80000000u;
+  free( scratch );
+}
+
+/** Documented in the header. */
+Sequence *sortSequence( Sequence const *seq )
+{
+  Sequence *sorted = makeSequence();
+  int n = seq->len;
+  if ( n == 0 )
+    return sorted;
+
+  if ( seq->width == 1 ) {
+    // Byte elements only have one digit, so a single counting pass does it.
+    int count[ 256 ] = { 0 };
+    for ( int i = 0; i < n; i++ )
+      count[ seq->bytes[ i ] + 128 ]++;
+
+    reserveSequence( sorted, n );
+    for ( int d = 0; d < 256; d++ ) {
+      memset( sorted->bytes + sorted->len, d - 128, count[ d ] );
+      sorted->len += count[ d ];
+    }
+    return sorted;
+  }
+
+  widenSequence( sorted );
+  reserveSequence( sorted, n );
+  memcpy( sorted->data, seq->data, n * sizeof( int ) );
+  sorted->len = n;
+  radixSort( sorted->data, n );
+  return sorted;
+}
+
+/**
+ * Find the first occurrence of one byte string in another.  With SSE2, sixteen starting
+ * positions are checked at once by comparing the first and last byte of the needle, and only
+ * positions where both match are compared in full
+ * @param hay the bytes to search
+ * @param n number of bytes in hay
+ * @param needle the bytes to look for, at least one and no more than n
+ * @param m number of bytes in needle
+ * @return index where needle starts, or -1 if it's not there
+*/
+static int findBytes( signed char const *hay, int n, signed char const *needle, int m )
+{
+  int i = 0;
+#ifdef __SSE2__
+  __m128i first = _mm_set1_epi8( needle[ 0 ] );
+  __m128i last = _mm_set1_epi8( needle[ m - 1 ] );
+  for ( ; i + 16 <= n - m + 1; i += 16 ) {
+    __m128i a = _mm_loadu_si128( (__m128i const *)( hay + i ) );
+    __m128i b = _mm_loadu_si128( (__m128i const *)( hay + i + m - 1 ) );
+    unsigned mask = _mm_movemask_epi8( _mm_and_si128( _mm_cmpeq_epi8( a, first ),
+                                                      _mm_cmpeq_epi8( b, last ) ) );
+    while ( mask ) {
+      int j = i + __builtin_ctz( mask );
+      if ( memcmp( hay + j, needle, m ) == 0 )
+        return j;
+      mask &= mask - 1;
+    }
+  }
+#endif
+  for ( ; i <= n - m; i++ )
+    if ( hay[ i ] == needle[ 0 ] && memcmp( hay + i, needle, m ) == 0 )
+      return i;
+  return -1;
+}
+
+/**
+ * Find the first occurrence of one int array in another, the same way as findBytes() but four
+ * starting positions at a time
+ * @param hay the ints to search
+ * @param n number of ints in hay
+ * @param needle the ints to look for, at least one and no more than n
+ * @param m number of ints in needle
+ * @return index where needle starts, or -1 if it's not there
+*/
+static int findInts( int const *hay, int n, int const *needle, int m )
+{
+  int i = 0;
+#ifdef __SSE2__
+  __m128i first = _mm_set1_epi32( needle[ 0 ] );
+  __m128i last = _mm_set1_epi32( needle[ m - 1 ] );
+  for ( ; i + 4 <= n - m + 1; i += 4 ) {
+    __m128i a = _mm_loadu_si128( (__m128i const *)( hay + i ) );
+    __m128i b = _mm_loadu_si128( (__m128i const *)( hay + i + m - 1 ) );
+    __m128i eq = _mm_and_si128( _mm_cmpeq_epi32( a, first ), _mm_cmpeq_epi32( b, last ) );
+    unsigned mask = _mm_movemask_ps( _mm_castsi128_ps( eq ) );
+    while ( mask ) {
+      int j = i + __builtin_ctz( mask );
+      if ( memcmp( hay + j, needle, m * sizeof( int ) ) == 0 )
+        return j;
+      mask &= mask - 1;
+    }
+  }
+#endif
+  for ( ; i <= n - m; i++ )
+    if ( hay[ i ] == needle[ 0 ] && memcmp( hay + i, needle, m * sizeof( int ) ) == 0 )
+      return i;
+  return -1;
+}
+
+/** Documented in the header. */
+int findSequence( Sequence const *seq, Sequence const *sub )
+{
+  int n = seq->len, m = sub->len;
+  if ( m == 0 )
+    return 0;
+  if ( m > n )
+    return -1;
+
+  if ( seq->width == 1 && sub->width == 1 )
+    return findBytes( seq->bytes, n, sub->bytes, m );
+  if ( seq->width != 1 && sub->width != 1 )
+    return findInts( seq->data, n, sub->data, m );
+
+  // Mixed storage, compare one element at a time.
+  for ( int i = 0; i <= n - m; i++ ) {
+    int j = 0;
+    while ( j < m && seqGet( seq, i + j ) == seqGet( sub, j ) )
+      j++;
+    if ( j == m )
+      return i;
+  }
+  return -1;
+}
+
 //////////////////////////////////////////////////////////////////////
 // Environment.
 /**
@@ -113,6 +370,30 @@ Value lookupVariable( Environment *env, char const *name )
   return (Value){ IntType, .ival = 0 };
 }
 
+/**
+ * See if a variable already exists, checking the position it was found at last time before searching
+ * @param env the environment where our variable is held
+ * @param name the name of our variable
+ * @param slot position where the variable was found last time, updated if it has moved
+ * @return the found value or zero if it was not found
+*/
+Value lookupCached( Environment *env, char const *name, int *slot )
+{
+  int pos = *slot;
+  if ( pos < env->len && env->vlist[ pos ].name[ 0 ] == name[ 0 ] &&
+       strcmp( env->vlist[ pos ].name, name ) == 0 )
+    return env->vlist[ pos ].val;
+
+  for ( int i = 0; i < env->len; i++ )
+    if ( strcmp( env->vlist[ i ].name, name ) == 0 ) {
+      *slot = i;
+      return env->vlist[ i ].val;
+    }
+
+  // Return zero for uninitialized variables.
+  return (Value){ IntType, .ival = 0 };
+}
+
 /**
  * Assign a variable a passed value
  * @param env the environment where we want to place the variable
@@ -136,16 +417,20 @@ void setVariable( Environment *env, char const *name, Value value )
   if ( pos == env->len ) {
     pos = env->len++;
     strcpy( env->vlist[ pos ].name, name );
+  } else if ( env->vlist[ pos ].val.vtype == SeqType ) {
+    // The variable no longer refers to its old sequence.
+    releaseSequence( env->vlist[ pos ].val.sval );
   }
   
   env->vlist[ pos ].val = value;
 }
 
 /**
- * Free environment, all elements, and handle all reference counts
+ * Remove all variables from the environment, releasing any sequences they hold, but keep the
+ * variable list allocated so the environment can be reused for another program
  * @param env the passed environment
 */
-void freeEnvironment( Environment *env )
+void clearEnvironment( Environment *env )
 {
   for(int i = 0; i < env->len; i++){
     if(env->vlist[i].val.vtype == SeqType){
@@ -153,6 +438,17 @@ void freeEnvironment( Environment *env )
     }
   }
 
+  env->len = 0;
+}
+
+/**
+ * Free environment, all elements, and handle all reference counts
+ * @param env the passed environment
+*/
+void freeEnvironment( Environment *env )
+{
+  clearEnvironment( env );
+
   free( env->vlist );
   free( env );
 }
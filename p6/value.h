@@ -12,18 +12,30 @@
 #include <stdbool.h>
 
 /** Representation for a seqeunce of integers.  One type of value supported
-    by the language. */
+    by the language.  While every element fits in a signed char (like the
+    characters of a string), elements are stored one byte each; the
+    storage is widened to ints the first time a larger value is stored.
+    Use the seqGet(), seqSet() and seqPush() functions to access elements. */
 typedef struct {
-  // ... Add any fields you need for representing a sequence of integers
-  // ... and delete this comment.
-  /** A point to an array of ints, this array is allocated on the heap and is resizable */
-  int *data;
+  union {
+    /** A point to an array of ints, this array is allocated on the heap and is resizable.
+        Used when width is sizeof( int ). */
+    int *data;
+
+    /** The same array, holding one byte per element when width is one. */
+    signed char *bytes;
+  };
   /** The number of elements currently held in a sequence */
   int len;
   /** The current capacity aka the number of elements our sequence has space for */
   int cap;
   /** Reference count for the sequence. */
   int ref;
+  /** Number of bytes used to store each element, either 1 or sizeof( int ). */
+  int width;
+  /** Hash of the elements, from seqHash(), or zero if it hasn't been
+      computed since the sequence last changed. */
+  unsigned hash;
 } Sequence;
 
 /** Create an empty sequence.
@@ -47,6 +59,100 @@ void grabSequence( Sequence *seq );
 */
 void releaseSequence( Sequence *seq );
 
+/** Switch a sequence from byte storage to int storage, so it can hold
+    any int value.
+    @param seq sequence to widen.
+*/
+void widenSequence( Sequence *seq );
+
+/** Make sure a sequence has room for at least one more element.
+    @param seq sequence that's about to grow.
+*/
+void growSequence( Sequence *seq );
+
+/** Return an element of a sequence.
+    @param seq sequence to get the element from.
+    @param i index of the element, which must be in bounds.
+    @return value of the element.
+*/
+static inline int seqGet( Sequence const *seq, int i )
+{
+  return seq->width == 1 ? seq->bytes[ i ] : seq->data[ i ];
+}
+
+/** Return true if the given value can be stored in a byte sequence.
+    @param val value to check.
+    @return true if val fits in a signed char.
+*/
+static inline bool fitsByte( int val )
+{
+  return val >= -128 && val <= 127;
+}
+
+/** Change an element of a sequence, widening the sequence if the value
+    doesn't fit in its current storage.
+    @param seq sequence to change.
+    @param i index of the element to change.
+    @param val new value for the element.
+*/
+static inline void seqSet( Sequence *seq, int i, int val )
+{
+  if ( seq->width == 1 && !fitsByte( val ) )
+    widenSequence( seq );
+
+  if ( seq->width == 1 )
+    seq->bytes[ i ] = val;
+  else
+    seq->data[ i ] = val;
+}
+
+/** Add an element to the end of a sequence, growing and widening it as
+    needed.
+    @param seq sequence to add to.
+    @param val value to add.
+*/
+static inline void seqPush( Sequence *seq, int val )
+{
+  if ( seq->len >= seq->cap )
+    growSequence( seq );
+  seqSet( seq, seq->len++, val );
+}
+
+/** Forget the cached hash for a sequence.  Anything that changes the
+    elements of a sequence that may already have been hashed must call
+    this.
+    @param seq sequence that's been changed.
+*/
+static inline void invalidateHash( Sequence *seq )
+{
+  seq->hash = 0;
+}
+
+/** Return a hash of the elements of a sequence, computing it the first
+    time and caching it in the sequence after that.  The hash depends only
+    on the values of the elements, not how they're stored, so sequences
+    that are equal always have the same hash.
+    @param seq sequence to hash.
+    @return hash of its elements, which is never zero.
+*/
+unsigned seqHash( Sequence *seq );
+
+/** Make a sorted copy of a sequence, in ascending order.  This uses a
+    radix sort, so it takes time linear in the length of the sequence.
+    @param seq sequence to sort, which isn't changed.
+    @return new sequence with a reference count of zero.
+*/
+Sequence *sortSequence( Sequence const *seq );
+
+/** Find where one sequence first occurs as a contiguous run of elements
+    in another.
+    @param seq sequence to search.
+    @param sub sequence to look for.
+    @return index of the first occurrence, zero if sub is empty, or -1 if
+    sub doesn't occur in seq.
+*/
+int findSequence( Sequence const *seq, Sequence const *sub );
+
 //////////////////////////////////////////////////////////////////////
 // Value Representat
 
@@ -102,14 +208,33 @@ Environment *makeEnvironment();
 */
 Value lookupVariable( Environment *env, char const *name );
 
+/** Same as lookupVariable(), but with an inline cache.  The slot
+    parameter remembers where the variable was found last time, so the
+    search can be skipped while the variable is still there.
+    @param env Environment object in which to lookup the variable.
+    @param name requested variable name.
+    @param slot cached position of the variable, updated by the lookup.
+    Callers should start it at zero.
+    @return the variable's value.
+*/
+Value lookupCached( Environment *env, char const *name, int *slot );
+
 /** In the given environment, set the named variable to store the given
-    value.
+    value.  If the variable held a sequence before, that sequence is
+    released, so the caller should already have grabbed a new sequence.
     @param env Environment in which to store the variable name / value.
     @param name of the variable to set the value for.
     @param value new value for this variable.
 */
 void setVariable( Environment *env, char const *name, Value value );
 
+/** Remove every variable from the environment, releasing the values
+    they hold.  The environment keeps its storage, so it's cheap to reuse
+    for running another program.
+    @param env environment to clear.
+*/
+void clearEnvironment( Environment *env );
+
 /** Free all the memory associated with this environment.
     @param env environment to free memory for.
 */